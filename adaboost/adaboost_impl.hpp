@@ -58,9 +58,6 @@ Adaboost<MatType, WeakLearner>::Adaboost(const MatType& data,
   // To be used for prediction by the Weak Learner for prediction.
   arma::Row<size_t> predictedLabels(labels.n_cols);
   
-  // Use tempData to modify input Data for incorporating weights.
-  MatType tempData(data);
-  
   // Build the classification Matrix yt from labels
   arma::mat yt(predictedLabels.n_cols, classes);
   
@@ -99,12 +96,12 @@ Adaboost<MatType, WeakLearner>::Adaboost(const MatType& data,
     zt = 0.0;
     
     // Build the weight vectors
-    D.print("The value of D in each iteration, just before going for training.");
     buildWeightMatrix(D, weights);
     // D.print("This is the value of D, before sending off to modify data");
     // call the other weak learner and train the labels.
-    WeakLearner w(other, tempData, weights, labels);
-    w.Classify(tempData, predictedLabels);
+    // The weak learner applies the weights itself, so the data is not copied.
+    WeakLearner w(other, data, weights, labels);
+    w.Classify(data, predictedLabels);
 
     //Now from predictedLabels, build ht, the weak hypothesis
     buildClassificationMatrix(ht, predictedLabels);
@@ -0,0 +1,56 @@
+/**
+ * @file allocation_counter.hpp
+ * @author Udit Saxena
+ *
+ * Heap allocation counter shared by the benchmark programs, which include it
+ * by relative path.  This replaces the C allocation functions, so it must be
+ * included by exactly one translation unit of a program; it is not part of
+ * the library, and is not installed.
+ */
+#ifndef __MLPACK_BENCH_ALLOCATION_COUNTER_HPP
+#define __MLPACK_BENCH_ALLOCATION_COUNTER_HPP
+
+#include <cerrno>
+#include <cstdlib>
+
+// Count every heap allocation, including those made by Armadillo, by
+// interposing the C allocation functions (this needs glibc).  Elsewhere, the
+// count stays at 0.
+static volatile size_t allocations = 0;
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size)
+{
+  __sync_fetch_and_add(&allocations, 1);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+  __sync_fetch_and_add(&allocations, 1);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+  __sync_fetch_and_add(&allocations, 1);
+  return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+  __sync_fetch_and_add(&allocations, 1);
+  *ptr = __libc_memalign(alignment, size);
+  return (*ptr == NULL) ? ENOMEM : 0;
+}
+}
+#endif
+
+#endif
@@ -307,4 +307,444 @@ BOOST_AUTO_TEST_CASE(DimensionSelectionTest)
   }
 }
 
+/**
+ * This tests that a stump trained with a presorted index is identical to one
+ * trained without it, and that one index can be reused for several stumps
+ * trained on different labels of the same data.
+ */
+BOOST_AUTO_TEST_CASE(PresortedIndexTest)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 3;
+
+  mat trainingData;
+  trainingData << -7 << -6 << -5 << -4 << -3 << -2 << -1 << 0 << 1
+               << 2  << 3  << 4  << 5  << 6  << 7  << 8  << 9 << 10 << endr
+               << 3  << 1  << 4  << 1  << 5  << 9  << 2  << 6 << 5
+               << 3  << 5  << 8  << 9  << 7  << 9  << 3  << 2 << 3 << endr;
+
+  // No need to normalize labels here.
+  Mat<size_t> labelsIn;
+  labelsIn << 0 << 0 << 0 << 0 << 1 << 1 << 0 << 0
+           << 1 << 1 << 1 << 2 << 1 << 2 << 2 << 2 << 2 << 2 << endr
+           << 2 << 2 << 2 << 1 << 1 << 1 << 0 << 0
+           << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2 << 0 << 0 << endr;
+
+  const PresortedIndex<> index(trainingData);
+
+  for (size_t r = 0; r < labelsIn.n_rows; ++r)
+  {
+    DecisionStump<> ds(trainingData, labelsIn.row(r), numClasses,
+        inpBucketSize);
+    DecisionStump<> dsIndexed(trainingData, labelsIn.row(r), numClasses,
+        inpBucketSize, index);
+
+    BOOST_REQUIRE_EQUAL(ds.SplitAttribute(), dsIndexed.SplitAttribute());
+    BOOST_REQUIRE_EQUAL(ds.Split().n_elem, dsIndexed.Split().n_elem);
+    for (size_t i = 0; i < ds.Split().n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(ds.Split()[i], dsIndexed.Split()[i]);
+      BOOST_REQUIRE_EQUAL(ds.BinLabels()[i], dsIndexed.BinLabels()[i]);
+    }
+  }
+}
+
+/**
+ * This tests the histogram-based training on the non-overlapping multiple class
+ * dataset, where two input values are put into each bin.  The split should
+ * still be perfect.
+ */
+BOOST_AUTO_TEST_CASE(HistogramMultiClassSplit)
+{
+  const size_t numClasses = 4;
+  const size_t inpBucketSize = 3;
+
+  mat trainingData;
+  trainingData << -8 << -7 << -6 << -5 << -4 << -3 << -2 << -1
+               << 0  << 1  << 2  << 3  << 4  << 5  << 6  << 7;
+
+  // No need to normalize labels here.
+  Mat<size_t> labelsIn;
+  labelsIn << 0 << 0 << 0 << 0 << 1 << 1 << 1 << 1
+           << 2 << 2 << 2 << 2 << 3 << 3 << 3 << 3;
+
+  mat testingData;
+  testingData << -6.1 << -2.1 << 1.1 << 5.1;
+
+  const QuantizedDataset<> quantizedData(trainingData, 8);
+  BOOST_REQUIRE_EQUAL(quantizedData.NumBins(0), 8);
+  BOOST_REQUIRE_EQUAL(quantizedData.Codes().n_rows, trainingData.n_cols);
+
+  DecisionStump<> ds(quantizedData, labelsIn.row(0), numClasses,
+      inpBucketSize);
+
+  Row<size_t> predictedLabels(testingData.n_cols);
+  ds.Classify(testingData, predictedLabels);
+
+  BOOST_CHECK_EQUAL(ds.Split().n_elem, 4);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 0), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 1), 1);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 2), 2);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 3), 3);
+}
+
+/**
+ * This tests that the splitting attribute and bins do not depend on the number
+ * of threads used to search the attributes, for both the exact and histogram
+ * training.
+ */
+BOOST_AUTO_TEST_CASE(ThreadCountIndependence)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 10;
+
+  arma::mat dataset = arma::randn<arma::mat>(40, 600);
+  arma::Row<size_t> labels(600);
+  for (size_t i = 0; i < 600; ++i)
+  {
+    labels[i] = i % numClasses;
+    dataset(17, i) += 2.0 * labels[i];
+    dataset(23, i) += 1.5 * labels[i];
+  }
+
+  const QuantizedDataset<> quantizedData(dataset);
+
+  DecisionStump<> ds1(dataset, labels, numClasses, inpBucketSize, 1);
+  DecisionStump<> ds4(dataset, labels, numClasses, inpBucketSize, 4);
+  DecisionStump<> dsh1(quantizedData, labels, numClasses, inpBucketSize, 1);
+  DecisionStump<> dsh4(quantizedData, labels, numClasses, inpBucketSize, 4);
+
+  BOOST_REQUIRE_EQUAL(ds1.SplitAttribute(), ds4.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(dsh1.SplitAttribute(), dsh4.SplitAttribute());
+
+  BOOST_REQUIRE_EQUAL(ds1.Split().n_elem, ds4.Split().n_elem);
+  for (size_t i = 0; i < ds1.Split().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(ds1.Split()[i], ds4.Split()[i]);
+
+  BOOST_REQUIRE_EQUAL(dsh1.Split().n_elem, dsh4.Split().n_elem);
+  for (size_t i = 0; i < dsh1.Split().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(dsh1.Split()[i], dsh4.Split()[i]);
+}
+
+/**
+ * This tests weighted training on a dataset where the classes are completely
+ * mixed, so that there is a single bucket, whose label must then be the class
+ * with the largest total weight.  It also checks that the boosting constructor
+ * and the histogram training agree.
+ */
+BOOST_AUTO_TEST_CASE(WeightedMostFrequentClass)
+{
+  const size_t numClasses = 2;
+  const size_t inpBucketSize = 6;
+
+  mat trainingData;
+  trainingData << -3 << -2 << -1 << 1 << 2 << 3;
+
+  // No need to normalize labels here.
+  Mat<size_t> labelsIn;
+  labelsIn << 0 << 1 << 0 << 1 << 0 << 1;
+
+  rowvec weights;
+  weights << 0.02 << 0.3 << 0.02 << 0.3 << 0.02 << 0.3;
+
+  mat testingData;
+  testingData << -2.5 << 0 << 2.5;
+
+  DecisionStump<> ds(trainingData, labelsIn.row(0), numClasses, inpBucketSize,
+      weights);
+
+  Row<size_t> predictedLabels(testingData.n_cols);
+  ds.Classify(testingData, predictedLabels);
+
+  for (size_t i = 0; i < predictedLabels.n_elem; ++i)
+    BOOST_CHECK_EQUAL(predictedLabels(i), 1);
+
+  // Now make the other class heavier, and train through the constructor used
+  // for boosting.
+  weights = 0.32 - weights;
+  DecisionStump<> dsBoost(ds, trainingData, weights, labelsIn.row(0));
+  dsBoost.Classify(testingData, predictedLabels);
+
+  for (size_t i = 0; i < predictedLabels.n_elem; ++i)
+    BOOST_CHECK_EQUAL(predictedLabels(i), 0);
+
+  const QuantizedDataset<> quantizedData(trainingData);
+  DecisionStump<> dsHist(quantizedData, labelsIn.row(0), numClasses,
+      inpBucketSize, weights);
+  dsHist.Classify(testingData, predictedLabels);
+
+  for (size_t i = 0; i < predictedLabels.n_elem; ++i)
+    BOOST_CHECK_EQUAL(predictedLabels(i), 0);
+}
+
+/**
+ * This tests classification with many bins, so that the binary search over the
+ * split values is used, including for points outside the range of the
+ * training data.
+ */
+BOOST_AUTO_TEST_CASE(ClassifyManyBins)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 2;
+
+  // Runs of two points, with labels cycling through the classes.
+  mat trainingData(1, 40);
+  Row<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+  {
+    trainingData(0, i) = i;
+    labels(i) = (i / 2) % 3;
+  }
+
+  DecisionStump<> ds(trainingData, labels, numClasses, inpBucketSize);
+  BOOST_REQUIRE_EQUAL(ds.Split().n_elem, 20);
+
+  mat testingData(1, 42);
+  for (size_t i = 0; i < 40; ++i)
+    testingData(0, i) = i + 0.5;
+  testingData(0, 40) = -1.0;
+  testingData(0, 41) = 100.0;
+
+  Row<size_t> predictedLabels(testingData.n_cols);
+  ds.Classify(testingData, predictedLabels);
+
+  for (size_t i = 0; i < 40; ++i)
+    BOOST_CHECK_EQUAL(predictedLabels(i), labels(i));
+  BOOST_CHECK_EQUAL(predictedLabels(40), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(41), 1);
+}
+
+/**
+ * This tests that a stump trained on feature-major data is the same as one
+ * trained on the usual column-major data, with both the exact and histogram
+ * training, and that it classifies feature-major test data in the same way.
+ */
+BOOST_AUTO_TEST_CASE(FeatureMajorTraining)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 5;
+
+  arma::mat dataset = arma::randu<arma::mat>(6, 200);
+  arma::Row<size_t> labels(200);
+  for (size_t i = 0; i < 200; ++i)
+    labels[i] = (dataset(4, i) < 0.3) ? 0 : ((dataset(4, i) < 0.6) ? 1 : 2);
+
+  const FeatureMajorMatrix fmDataset(dataset);
+  BOOST_REQUIRE_EQUAL(fmDataset.n_rows, dataset.n_rows);
+  BOOST_REQUIRE_EQUAL(fmDataset.n_cols, dataset.n_cols);
+
+  DecisionStump<> ds(dataset, labels, numClasses, inpBucketSize);
+  DecisionStump<FeatureMajorMatrix> fmds(fmDataset, labels, numClasses,
+      inpBucketSize);
+
+  BOOST_REQUIRE_EQUAL(ds.SplitAttribute(), 4);
+  BOOST_REQUIRE_EQUAL(fmds.SplitAttribute(), ds.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(fmds.Split().n_elem, ds.Split().n_elem);
+  for (size_t i = 0; i < ds.Split().n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(fmds.Split()[i], ds.Split()[i]);
+    BOOST_REQUIRE_EQUAL(fmds.BinLabels()[i], ds.BinLabels()[i]);
+  }
+
+  const QuantizedDataset<FeatureMajorMatrix> fmQuantized(fmDataset, 32);
+  const QuantizedDataset<> quantized(dataset, 32);
+  DecisionStump<FeatureMajorMatrix> fmdsHist(fmQuantized, labels, numClasses,
+      inpBucketSize);
+  DecisionStump<> dsHist(quantized, labels, numClasses, inpBucketSize);
+  BOOST_REQUIRE_EQUAL(fmdsHist.SplitAttribute(), dsHist.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(fmdsHist.Split().n_elem, dsHist.Split().n_elem);
+
+  arma::mat testData = arma::randu<arma::mat>(6, 50);
+  const FeatureMajorMatrix fmTestData(arma::mat(testData.t()), true);
+
+  Row<size_t> predictedLabels(testData.n_cols);
+  Row<size_t> fmPredictedLabels(testData.n_cols);
+  ds.Classify(testData, predictedLabels);
+  fmds.Classify(fmTestData, fmPredictedLabels);
+
+  for (size_t i = 0; i < testData.n_cols; ++i)
+    BOOST_CHECK_EQUAL(fmPredictedLabels[i], predictedLabels[i]);
+}
+
+/**
+ * This tests training on sparse data, where the splitting attribute is negative
+ * for class 0, zero (implicitly) for class 1 and positive for class 2, so that
+ * the implicit zeros form a bucket of their own.  Test points which have no
+ * nonzero in the splitting attribute must be classified as class 1.
+ */
+BOOST_AUTO_TEST_CASE(SparseTraining)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 3;
+
+  arma::sp_mat trainingData(5, 30);
+  arma::Row<size_t> labels(30);
+  for (size_t i = 0; i < 30; ++i)
+  {
+    labels[i] = i / 10;
+    if (labels[i] == 0)
+      trainingData(2, i) = -1.0 - (double) i;
+    else if (labels[i] == 2)
+      trainingData(2, i) = (double) i;
+
+    // Some sparse noise in other attributes.
+    if (i % 4 == 0)
+      trainingData(0, i) = (double) (i % 7) + 1.0;
+    if (i % 3 == 1)
+      trainingData(4, i) = -((double) (i % 5) + 1.0);
+  }
+
+  DecisionStump<arma::sp_mat> ds(trainingData, labels, numClasses,
+      inpBucketSize);
+
+  BOOST_REQUIRE_EQUAL(ds.SplitAttribute(), 2);
+  BOOST_REQUIRE_EQUAL(ds.Split().n_elem, 3);
+  BOOST_CHECK_EQUAL(ds.Split()[0], -10.0);
+  BOOST_CHECK_EQUAL(ds.Split()[1], 0.0);
+  BOOST_CHECK_EQUAL(ds.Split()[2], 20.0);
+  BOOST_CHECK_EQUAL(ds.BinLabels()[0], 0);
+  BOOST_CHECK_EQUAL(ds.BinLabels()[1], 1);
+  BOOST_CHECK_EQUAL(ds.BinLabels()[2], 2);
+
+  arma::sp_mat testData(5, 4);
+  testData(2, 0) = -5.0;
+  testData(0, 1) = 3.0;
+  testData(2, 2) = 25.0;
+  testData(4, 3) = -2.0;
+
+  Row<size_t> predictedLabels(testData.n_cols);
+  ds.Classify(testData, predictedLabels);
+
+  BOOST_CHECK_EQUAL(predictedLabels[0], 0);
+  BOOST_CHECK_EQUAL(predictedLabels[1], 1);
+  BOOST_CHECK_EQUAL(predictedLabels[2], 2);
+  BOOST_CHECK_EQUAL(predictedLabels[3], 1);
+
+  // The weighted (boosting) constructor takes the same path.
+  const arma::rowvec weights = arma::ones<arma::rowvec>(30) / 30.0;
+  DecisionStump<arma::sp_mat> weighted(ds, trainingData, weights, labels);
+  BOOST_CHECK_EQUAL(weighted.SplitAttribute(), 2);
+}
+
+/**
+ * This tests that a stump trained on a dataset streamed in chunks, when the
+ * sketch is large enough to hold every point, is the same as one trained on
+ * the quantized dataset.
+ */
+BOOST_AUTO_TEST_CASE(StreamingHistogramTraining)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 4;
+  const size_t bins = 32;
+
+  arma::mat dataset = arma::randu<arma::mat>(5, 300);
+  arma::Row<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+    labels[i] = (dataset(1, i) < 0.25) ? 0 : ((dataset(1, i) < 0.7) ? 1 : 2);
+
+  // Stream the dataset in uneven chunks.
+  const size_t chunkSize = 37;
+  StreamingHistogram histogram(dataset.n_rows, numClasses, bins, 1000);
+  for (size_t begin = 0; begin < dataset.n_cols; begin += chunkSize)
+  {
+    const size_t end = std::min(begin + chunkSize, (size_t) dataset.n_cols);
+    histogram.Sketch(dataset.cols(begin, end - 1));
+  }
+  histogram.ComputeBinEdges();
+  for (size_t begin = 0; begin < dataset.n_cols; begin += chunkSize)
+  {
+    const size_t end = std::min(begin + chunkSize, (size_t) dataset.n_cols);
+    histogram.Count(dataset.cols(begin, end - 1),
+        labels.cols(begin, end - 1));
+  }
+  BOOST_REQUIRE_EQUAL(histogram.NumPoints(), 300);
+
+  DecisionStump<> streamed(histogram, inpBucketSize);
+  DecisionStump<> quantized(QuantizedDataset<>(dataset, bins), labels,
+      numClasses, inpBucketSize);
+
+  BOOST_REQUIRE_EQUAL(streamed.SplitAttribute(), 1);
+  BOOST_REQUIRE_EQUAL(streamed.SplitAttribute(), quantized.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(streamed.Split().n_elem, quantized.Split().n_elem);
+  for (size_t i = 0; i < streamed.Split().n_elem; ++i)
+  {
+    BOOST_CHECK_EQUAL(streamed.Split()[i], quantized.Split()[i]);
+    BOOST_CHECK_EQUAL(streamed.BinLabels()[i], quantized.BinLabels()[i]);
+  }
+}
+
+/**
+ * This tests that a stump saved to a binary model file and loaded again with
+ * MappedStumpModel is the same as the original, and classifies the same way.
+ */
+BOOST_AUTO_TEST_CASE(SaveLoadModel)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 4;
+
+  arma::mat dataset = arma::randu<arma::mat>(4, 200);
+  arma::Row<size_t> labels(200);
+  for (size_t i = 0; i < 200; ++i)
+    labels[i] = (dataset(3, i) < 0.3) ? 0 : ((dataset(3, i) < 0.8) ? 1 : 2);
+
+  DecisionStump<> ds(dataset, labels, numClasses, inpBucketSize);
+
+  arma::vec labelValues("-1 4 7");
+  ds.Save("decision_stump_model.bin", labelValues);
+
+  {
+    MappedStumpModel model("decision_stump_model.bin");
+    BOOST_REQUIRE_EQUAL(model.Header().numLabelValues, 3);
+    for (size_t i = 0; i < 3; ++i)
+      BOOST_CHECK_EQUAL(model.LabelValues()[i], labelValues[i]);
+
+    DecisionStump<> loaded(model);
+    BOOST_REQUIRE_EQUAL(loaded.SplitAttribute(), ds.SplitAttribute());
+    BOOST_REQUIRE_EQUAL(loaded.Split().n_elem, ds.Split().n_elem);
+    for (size_t i = 0; i < ds.Split().n_elem; ++i)
+    {
+      BOOST_CHECK_EQUAL(loaded.Split()[i], ds.Split()[i]);
+      BOOST_CHECK_EQUAL(loaded.BinLabels()[i], ds.BinLabels()[i]);
+    }
+
+    arma::mat testData = arma::randu<arma::mat>(4, 50);
+    Row<size_t> predictedLabels(testData.n_cols);
+    Row<size_t> loadedPredictedLabels(testData.n_cols);
+    ds.Classify(testData, predictedLabels);
+    loaded.Classify(testData, loadedPredictedLabels);
+    for (size_t i = 0; i < testData.n_cols; ++i)
+      BOOST_CHECK_EQUAL(loadedPredictedLabels[i], predictedLabels[i]);
+  }
+
+  remove("decision_stump_model.bin");
+}
+
+/**
+ * This tests that classifying points one at a time with Predict() gives the
+ * same labels as classifying them together with Classify().
+ */
+BOOST_AUTO_TEST_CASE(PredictMatchesClassify)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 4;
+
+  arma::mat dataset = arma::randu<arma::mat>(4, 200);
+  arma::Row<size_t> labels(200);
+  for (size_t i = 0; i < 200; ++i)
+    labels[i] = (dataset(1, i) < 0.3) ? 0 : ((dataset(1, i) < 0.8) ? 1 : 2);
+
+  const DecisionStump<> ds(dataset, labels, numClasses, inpBucketSize);
+
+  arma::mat testData = arma::randu<arma::mat>(4, 100);
+  Row<size_t> predictedLabels(testData.n_cols);
+  ds.Classify(testData, predictedLabels);
+
+  for (size_t i = 0; i < testData.n_cols; ++i)
+  {
+    BOOST_CHECK_EQUAL(ds.Predict(testData.colptr(i)), predictedLabels[i]);
+    BOOST_CHECK_EQUAL(ds.Predict(arma::vec(testData.col(i))),
+        predictedLabels[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
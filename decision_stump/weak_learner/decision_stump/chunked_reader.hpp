@@ -0,0 +1,161 @@
+/**
+ * @file chunked_reader.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the ChunkedReader class, which reads a text dataset a fixed
+ * number of points at a time.
+ */
+#ifndef __MLPACK_METHODS_DECISION_STUMP_CHUNKED_READER_HPP
+#define __MLPACK_METHODS_DECISION_STUMP_CHUNKED_READER_HPP
+
+#include <mlpack/core.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace decision_stump {
+
+/**
+ * This class reads a dataset stored as text (one point per line, with values
+ * separated by commas, spaces or tabs, as in a CSV file) in chunks of at most
+ * chunkSize points, so that only one chunk is in memory at a time.  The file
+ * can be read again from the start with Reset(), which allows training in
+ * several passes.
+ *
+ * @code
+ * ChunkedReader reader("train.csv", 10000);
+ * arma::mat chunk;
+ * while (reader.Next(chunk))
+ *   ...
+ * @endcode
+ */
+class ChunkedReader
+{
+ public:
+  /**
+   * Open the given file.  Its dimensionality is taken from the first line.
+   *
+   * @param filename File to read.
+   * @param chunkSize Maximum number of points in each chunk.
+   */
+  ChunkedReader(const std::string& filename, const size_t chunkSize) :
+      filename(filename),
+      chunkSize(chunkSize),
+      stream(filename.c_str()),
+      dimensionality(0),
+      line(0)
+  {
+    if (!stream.is_open())
+      Log::Fatal << "ChunkedReader: cannot open file '" << filename << "'!"
+          << std::endl;
+    if (chunkSize == 0)
+      Log::Fatal << "ChunkedReader: chunk size must be positive!" << std::endl;
+
+    std::string text;
+    while (dimensionality == 0 && std::getline(stream, text))
+      dimensionality = Parse(text);
+
+    Reset();
+  }
+
+  //! Get the number of attributes of each point of the file.
+  size_t Dimensionality() const { return dimensionality; }
+
+  /**
+   * Read the next chunk of points.
+   *
+   * @param chunk Matrix to store the chunk in (one point per column).
+   * @return false if there were no points left to read.
+   */
+  bool Next(arma::mat& chunk)
+  {
+    chunk.set_size(dimensionality, chunkSize);
+
+    size_t count = 0;
+    std::string text;
+    while (count < chunkSize && std::getline(stream, text))
+    {
+      ++line;
+      const size_t n = Parse(text);
+      if (n == 0)
+        continue; // Skip empty lines.
+
+      if (n != dimensionality)
+        Log::Fatal << "ChunkedReader: line " << line << " of '" << filename
+            << "' has " << n << " values, but " << dimensionality
+            << " were expected!" << std::endl;
+
+      std::copy(values.begin(), values.end(), chunk.colptr(count));
+      ++count;
+    }
+
+    if (count < chunkSize)
+      chunk.resize(dimensionality, count);
+
+    return (count > 0);
+  }
+
+  //! Go back to the start of the file.
+  void Reset()
+  {
+    stream.clear();
+    stream.seekg(0, std::ios::beg);
+    line = 0;
+  }
+
+ private:
+  /**
+   * Parse the values of one line into the values vector.
+   *
+   * @return The number of values on the line.
+   */
+  size_t Parse(const std::string& text)
+  {
+    values.clear();
+    const char* p = text.c_str();
+    while (true)
+    {
+      while (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r')
+        ++p;
+      if (*p == '\0')
+        break;
+
+      char* end;
+      const double value = std::strtod(p, &end);
+      if (end == p)
+        Log::Fatal << "ChunkedReader: cannot parse line " << line << " of '"
+            << filename << "'!" << std::endl;
+
+      values.push_back(value);
+      p = end;
+    }
+
+    return values.size();
+  }
+
+  //! The name of the file being read.
+  std::string filename;
+
+  //! The maximum number of points in each chunk.
+  size_t chunkSize;
+
+  //! The stream the file is read from.
+  std::ifstream stream;
+
+  //! The number of attributes of each point.
+  size_t dimensionality;
+
+  //! The number of the last line read.
+  size_t line;
+
+  //! The values of the last line read.
+  std::vector<double> values;
+};
+
+}; // namespace decision_stump
+}; // namespace mlpack
+
+#endif
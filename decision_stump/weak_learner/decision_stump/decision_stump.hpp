@@ -9,6 +9,12 @@
 
 #include <mlpack/core.hpp>
 
+#include "feature_major_matrix.hpp"
+#include "mapped_stump_model.hpp"
+#include "presorted_index.hpp"
+#include "quantized_dataset.hpp"
+#include "streaming_histogram.hpp"
+
 namespace mlpack {
 namespace decision_stump {
 
@@ -23,7 +29,12 @@ namespace decision_stump {
  * last bin has range up to \infty (split[i + 1] does not exist in that case).
  * Points that are below the first bin will take the label of the first bin.
  *
- * @tparam MatType Type of matrix that is being used (sparse or dense).
+ * @tparam MatType Type of matrix that is being used (sparse or dense).  A
+ *     FeatureMajorMatrix may also be used, so that each attribute is read from
+ *     contiguous memory during training.  With arma::sp_mat, only the nonzero
+ *     values are sorted, the implicit zeros of each attribute are handled as a
+ *     single block, and classification only visits the nonzeros of the test
+ *     data, so training and classification cost O(nnz) rather than O(d n).
  */
 template <typename MatType = arma::mat>
 class DecisionStump
@@ -37,29 +48,211 @@ class DecisionStump
    * @param labels Labels of training data.
    * @param classes Number of distinct classes in labels.
    * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
+   */
+  DecisionStump(const MatType& data,
+                const arma::Row<size_t>& labels,
+                const size_t classes,
+                size_t inpBucketSize,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Train on the provided data, using a PresortedIndex which has
+   * already been built for it.  This avoids sorting every attribute of the data
+   * again, so it is the constructor to use when many stumps are trained on the
+   * same dataset.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of training data.
+   * @param classes Number of distinct classes in labels.
+   * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param index Presorted index built from data.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
+   */
+  DecisionStump(const MatType& data,
+                const arma::Row<size_t>& labels,
+                const size_t classes,
+                size_t inpBucketSize,
+                const PresortedIndex<MatType>& index,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Train on the provided data, where each point carries the given
+   * instance weight.  Buckets are labeled with the class of largest total
+   * weight, and entropies are computed from weighted class proportions;
+   * bucket sizes are still counted in points.  The data is not copied, so
+   * boosting can train a stump on the original data each round.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of training data.
+   * @param classes Number of distinct classes in labels.
+   * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param weights Weight of each point of the training data.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
+   */
+  DecisionStump(const MatType& data,
+                const arma::Row<size_t>& labels,
+                const size_t classes,
+                size_t inpBucketSize,
+                const arma::rowvec& weights,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Train on the provided weighted data, using a PresortedIndex
+   * which has already been built for it.  This is the cheapest way to train a
+   * stump in every round of boosting, as neither the data nor its sort order
+   * changes between rounds.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of training data.
+   * @param classes Number of distinct classes in labels.
+   * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param index Presorted index built from data.
+   * @param weights Weight of each point of the training data.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
    */
   DecisionStump(const MatType& data,
                 const arma::Row<size_t>& labels,
                 const size_t classes,
-                size_t inpBucketSize);
+                size_t inpBucketSize,
+                const PresortedIndex<MatType>& index,
+                const arma::rowvec& weights,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Train on the provided quantized data.  Instead of sorting
+   * each attribute, the split is found with a single pass over each attribute
+   * to build a histogram of class counts for each bin, followed by a sweep
+   * over the bins.  The bins of the trained stump therefore start at bin edges
+   * of the quantized data.
+   *
+   * @param data Input, quantized training data.
+   * @param labels Labels of training data.
+   * @param classes Number of distinct classes in labels.
+   * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
+   */
+  DecisionStump(const QuantizedDataset<MatType>& data,
+                const arma::Row<size_t>& labels,
+                const size_t classes,
+                size_t inpBucketSize,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Train on the provided weighted quantized data, using
+   * class-count histograms where each point counts with its weight.
+   *
+   * @param data Input, quantized training data.
+   * @param labels Labels of training data.
+   * @param classes Number of distinct classes in labels.
+   * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param weights Weight of each point of the training data.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
+   */
+  DecisionStump(const QuantizedDataset<MatType>& data,
+                const arma::Row<size_t>& labels,
+                const size_t classes,
+                size_t inpBucketSize,
+                const arma::rowvec& weights,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Train on the class-count histograms of a dataset which has
+   * been streamed in chunks, so that it never had to be held in memory.  As
+   * with quantized data, the bins of the trained stump start at bin edges of
+   * the histogram.
+   *
+   * @param histogram Histograms of the training data (after both passes).
+   * @param inpBucketSize Minimum size of bucket when splitting.
+   * @param threads Number of threads used to search the attributes; 0 means
+   *     the OpenMP default.
+   */
+  DecisionStump(const StreamingHistogram& histogram,
+                size_t inpBucketSize,
+                const size_t threads = 0);
+
+  /**
+   * Constructor. Load a stump from a mapped model file.  The split values and
+   * bin labels are used in place, without copying, so the stump must not
+   * outlive the model.
+   *
+   * @param model Mapped model file, written by Save().
+   * @param threads Number of threads used to classify points; 0 means the
+   *     OpenMP default.
+   */
+  DecisionStump(const MappedStumpModel& model, const size_t threads = 0);
+
+  /**
+   * Constructor for use as a weak learner in boosting.  Train a new stump on
+   * the given weighted data, with the same number of classes, bucket size and
+   * number of threads as an existing stump.
+   *
+   * @param other Stump to take the training parameters from.
+   * @param data Input, training data.
+   * @param weights Weight of each point of the training data.
+   * @param labels Labels of training data.
+   */
+  DecisionStump(const DecisionStump& other,
+                const MatType& data,
+                const arma::rowvec& weights,
+                const arma::Row<size_t>& labels);
 
   /**
    * Classification function. After training, classify test, and put the
-   * predicted classes in predictedLabels.
+   * predicted classes in predictedLabels.  The splitting attribute of the test
+   * points is gathered into a contiguous vector, and the points are then
+   * classified in blocks (in parallel, if OpenMP is available) by binary search
+   * over the split values, or by branchless counting when there are few bins.
    *
    * @param test Testing data or data to classify.
    * @param predictedLabels Vector to store the predicted classes after
    *     classifying test data.
    */
-  void Classify(const MatType& test, arma::Row<size_t>& predictedLabels);
-  
+  void Classify(const MatType& test,
+                arma::Row<size_t>& predictedLabels) const;
+
   /**
+   * Classify a single point.  This only looks up the splitting attribute of the
+   * point, does not allocate memory, and is safe to call from several threads
+   * at once, so it suits low-latency serving.  The point is not checked: it
+   * must have at least SplitAttribute() + 1 values.
    *
+   * @param point Point to classify (with one value per attribute).
+   * @return The predicted class of the point.
+   */
+  size_t Predict(const double* point) const
+  { return binLabels[Bin(point[splitAttribute])]; }
+
+  /**
+   * Classify a single point.  This does not allocate memory.  Unlike the
+   * pointer version, the point is checked to have the splitting attribute.
    *
+   * @param point Point to classify.
+   * @return The predicted class of the point.
+   */
+  size_t Predict(const arma::vec& point) const
+  {
+    if (point.n_elem <= (size_t) splitAttribute)
+      Log::Fatal << "DecisionStump: point dimensionality (" << point.n_elem
+          << ") does not include the splitting attribute (" << splitAttribute
+          << ")!" << std::endl;
+
+    return Predict(point.memptr());
+  }
+  
+  /**
+   * Copy constructor.  Copy the trained stump (and its training parameters)
+   * from another stump of the same type.
    *
-   *
+   * @param ds Stump to copy.
    */
-  DecisionStump(const DecisionStump<>& ds);
+  DecisionStump(const DecisionStump& ds);
 
   /**
    *
@@ -71,6 +264,17 @@ class DecisionStump
   ModifyData(MatType& data);
   */
   
+  /**
+   * Save the stump to the given file, in the compact binary format described
+   * by StumpModelHeader.  The file can be loaded again with MappedStumpModel.
+   *
+   * @param filename File to save to.
+   * @param labelValues Original values of the labels (optional), so that a
+   *     program loading the model can map its predictions back to them.
+   */
+  void Save(const std::string& filename,
+            const arma::vec& labelValues = arma::vec()) const;
+
   //! Access the splitting attribute.
   int SplitAttribute() const { return splitAttribute; }
   //! Modify the splitting attribute (be careful!).
@@ -96,31 +300,200 @@ class DecisionStump
   //! Size of bucket while determining splitting criterion.
   size_t bucketSize;
 
+  //! Number of threads used to search the attributes during training, and to
+  //! classify points.
+  int numThreads;
+
   //! Stores the splitting values after training.
   arma::vec split;
 
   //! Stores the labels for each splitting bin.
   arma::Col<size_t> binLabels;
 
+  /**
+   * Find the bin that the given value of the splitting attribute falls into.
+   *
+   * @param val Value of the splitting attribute.
+   */
+  size_t Bin(const double val) const;
+
+  /**
+   * Set the number of threads used during training; 0 means the OpenMP
+   * default.  Without OpenMP, training always uses one thread.
+   *
+   * @param threads Requested number of threads.
+   */
+  void SetThreads(const size_t threads);
+
+  /**
+   * Find the best splitting attribute using the given presorted index, and then
+   * train on it.
+   *
+   * @tparam UseWeights Whether or not to use the instance weights.
+   * @param data Input, training data.
+   * @param labels Labels of training data.
+   * @param index Presorted index built from data.
+   * @param weights Weight of each point (ignored if UseWeights is false).
+   */
+  template <bool UseWeights>
+  void Train(const MatType& data,
+             const arma::Row<size_t>& labels,
+             const PresortedIndex<MatType>& index,
+             const arma::rowvec& weights);
+
   /**
    * Sets up attribute as if it were splitting on it and finds entropy when
    * splitting on attribute.
    *
-   * @param attribute A row from the training data, which might be a
-   *     candidate for the splitting attribute.
+   * @tparam UseWeights Whether or not to use the instance weights.
+   * @param sortedOrder Indices of the points of a candidate splitting
+   *     attribute, in sorted order.
+   * @param labels Labels of training data.
+   * @param weights Weight of each point (ignored if UseWeights is false).
+   * @param totalWeight Total weight of all points (or the number of points if
+   *     UseWeights is false).
+   * @param classCounts Scratch vector of length numClass, all zeros on entry
+   *     and on return.
    */
-  double SetupSplitAttribute(const arma::rowvec& attribute,
-                             const arma::Row<size_t>& labels);
+  template <bool UseWeights>
+  double SetupSplitAttribute(const arma::subview_col<arma::uword>& sortedOrder,
+                             const arma::Row<size_t>& labels,
+                             const arma::rowvec& weights,
+                             const double totalWeight,
+                             arma::vec& classCounts);
 
   /**
    * After having decided the attribute on which to split, train on that
    * attribute.
    *
+   * @tparam UseWeights Whether or not to use the instance weights.
    * @param attribute attribute is the attribute decided by the constructor
    *      on which we now train the decision stump.
+   * @param sortedOrder Indices of the points of attribute, in sorted order.
+   * @param labels Labels of training data.
+   * @param weights Weight of each point (ignored if UseWeights is false).
+   */
+  template <bool UseWeights> void TrainOnAtt(
+      const arma::rowvec& attribute,
+      const arma::subview_col<arma::uword>& sortedOrder,
+      const arma::Row<size_t>& labels,
+      const arma::rowvec& weights);
+
+  /**
+   * Sets up an attribute of sparse data as if it were splitting on it and finds
+   * entropy when splitting on it; if train is true, the split values and bin
+   * labels are set up too, as TrainOnAtt() does.  Used by
+   * DecisionStump<arma::sp_mat>.
+   *
+   * The sorted points are the negative nonzeros, then the implicit zeros as a
+   * single block (which is never split, and whose label is its most frequent
+   * class), then the positive nonzeros.
+   *
+   * @tparam UseWeights Whether or not to use the instance weights.
+   * @param index Presorted index built from the sparse training data.
+   * @param attribute Candidate splitting attribute.
+   * @param labels Labels of training data.
+   * @param weights Weight of each point (ignored if UseWeights is false).
+   * @param totalCounts Total (weighted) count of each class.
+   * @param totalWeight Total weight of all points (or the number of points if
+   *     UseWeights is false).
+   * @param classCounts Scratch vector of length numClass, all zeros on entry
+   *     and on return.
+   * @param zeroCounts Scratch vector of length numClass.
+   * @param train Whether or not to set up the split values and bin labels.
+   */
+  template <bool UseWeights>
+  double SweepSparseAttribute(const PresortedIndex<arma::sp_mat>& index,
+                              const size_t attribute,
+                              const arma::Row<size_t>& labels,
+                              const arma::rowvec& weights,
+                              const arma::vec& totalCounts,
+                              const double totalWeight,
+                              arma::vec& classCounts,
+                              arma::vec& zeroCounts,
+                              const bool train);
+
+  /**
+   * Find the best splitting attribute from class-count histograms of the
+   * quantized data, and then train on it.
+   *
+   * @tparam UseWeights Whether or not to use the instance weights.
+   * @param data Input, quantized training data.
+   * @param labels Labels of training data.
+   * @param weights Weight of each point (ignored if UseWeights is false).
+   */
+  template <bool UseWeights>
+  void TrainHistogram(const QuantizedDataset<MatType>& data,
+                      const arma::Row<size_t>& labels,
+                      const arma::rowvec& weights);
+
+  /**
+   * Count the points of each class falling into each bin of an attribute of
+   * the quantized data.
+   *
+   * @tparam UseWeights Whether or not to count each point with its weight.
+   * @param data Input, quantized training data.
+   * @param attribute Attribute to build the histogram of.
+   * @param labels Labels of training data.
+   * @param weights Weight of each point (ignored if UseWeights is false).
+   * @param binCounts Output matrix holding, for each bin (column), the
+   *     (weighted) count of each class (row).
+   * @param binSizes Output vector holding the number of points in each bin.
+   */
+  template <bool UseWeights>
+  void BuildHistogram(const QuantizedDataset<MatType>& data,
+                      const size_t attribute,
+                      const arma::Row<size_t>& labels,
+                      const arma::rowvec& weights,
+                      arma::mat& binCounts,
+                      arma::vec& binSizes);
+
+  /**
+   * Finds the entropy when splitting on an attribute, given its histogram.
+   *
+   * @param binCounts Class counts of each bin of the attribute.
+   * @param binSizes Number of points in each bin of the attribute.
+   */
+  double SetupSplitHistogram(const arma::mat& binCounts,
+                             const arma::vec& binSizes);
+
+  /**
+   * After having decided the attribute on which to split, train on its
+   * histogram.
+   *
+   * @param binCounts Class counts of each bin of the attribute.
+   * @param binSizes Number of points in each bin of the attribute.
+   * @param binEdges Lower edges of each bin of the attribute.
    */
-  template <typename rType> void TrainOnAtt(const arma::rowvec& attribute,
-                                            const arma::Row<size_t>& labels);
+  void TrainOnHistogram(const arma::mat& binCounts,
+                        const arma::vec& binSizes,
+                        const arma::vec& binEdges);
+
+  /**
+   * Group the bins of a histogram into a bucket, starting at the given bin.
+   * As with the exact sort-based splitting, a bucket is ended where the most
+   * frequent class changes from one bin to the next, but only once it holds at
+   * least bucketSize points.
+   *
+   * @param binCounts Class counts of each bin of the attribute.
+   * @param binSizes Number of points in each bin of the attribute.
+   * @param begin First bin of the bucket.
+   * @param bucketCounts Output vector holding the class counts of the bucket.
+   * @return One past the last bin of the bucket.
+   */
+  size_t NextHistogramBucket(const arma::mat& binCounts,
+                             const arma::vec& binSizes,
+                             const size_t begin,
+                             arma::vec& bucketCounts);
+
+  /**
+   * Find the class with the largest count in the given column of counts.  Ties
+   * go to the lowest class.
+   *
+   * @param counts Matrix of class counts.
+   * @param col Column of counts to look at.
+   */
+  size_t MajorityClass(const arma::mat& counts, const size_t col);
 
   /**
    * After the "split" matrix has been set up, merge ranges with identical class
@@ -137,11 +510,14 @@ class DecisionStump
   template <typename rType> rType CountMostFreq(const arma::Row<rType>& subCols);
 
   /**
-   * Returns 1 if all the values of featureRow are not same.
+   * Find the element of subCols with the largest total weight.
    *
-   * @param featureRow The attribute which is checked for identical values.
+   * @param subCols The vector of class labels in which to find the heaviest
+   *     element.
+   * @param weights The weight of each element of subCols.
    */
-  template <typename rType> int IsDistinct(const arma::Row<rType>& featureRow);
+  template <typename rType> rType CountMostFreq(const arma::Row<rType>& subCols,
+                                                const arma::rowvec& weights);
 
   /**
    * Calculate the entropy of the given attribute.
@@ -151,6 +527,17 @@ class DecisionStump
    */
   template <typename AttType, typename LabelType>
   double CalculateEntropy(arma::subview_row<LabelType> labels);
+
+  /**
+   * Calculate the entropy of the given weighted labels, using the weighted
+   * proportion of each class.
+   *
+   * @param labels Corresponding labels of the attribute.
+   * @param weights Weight of each label.
+   */
+  template <typename AttType, typename LabelType>
+  double CalculateEntropy(arma::subview_row<LabelType> labels,
+                          arma::subview_row<double> weights);
 };
 
 }; // namespace decision_stump
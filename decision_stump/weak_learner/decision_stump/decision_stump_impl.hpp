@@ -14,6 +14,10 @@
 #include <set>
 #include <algorithm>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace decision_stump {
 
@@ -24,51 +28,269 @@ namespace decision_stump {
  * @param labels Labels of data.
  * @param classes Number of distinct classes in labels.
  * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param threads Number of threads used to search the attributes.
  */
 template<typename MatType>
 DecisionStump<MatType>::DecisionStump(const MatType& data,
                                       const arma::Row<size_t>& labels,
                                       const size_t classes,
-                                      size_t inpBucketSize)
+                                      size_t inpBucketSize,
+                                      const size_t threads)
 {
   numClass = classes;
   bucketSize = inpBucketSize;
+  SetThreads(threads);
 
-  // If classLabels are not all identical, proceed with training.
-  int bestAtt = 0;
-  double entropy;
-  const double rootEntropy = CalculateEntropy<size_t>(
-      labels.subvec(0, labels.n_elem - 1));
+  // Sort every attribute once; the index is thrown away after training.
+  const PresortedIndex<MatType> index(data);
+  Train<false>(data, labels, index, arma::rowvec());
+}
+
+/**
+ * Constructor. Train on the provided data, using an already-built presorted
+ * index for it.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of data.
+ * @param classes Number of distinct classes in labels.
+ * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param index Presorted index built from data.
+ * @param threads Number of threads used to search the attributes.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const MatType& data,
+                                      const arma::Row<size_t>& labels,
+                                      const size_t classes,
+                                      size_t inpBucketSize,
+                                      const PresortedIndex<MatType>& index,
+                                      const size_t threads)
+{
+  numClass = classes;
+  bucketSize = inpBucketSize;
+  SetThreads(threads);
+
+  if ((index.NumPoints() != data.n_cols) ||
+      (index.Dimensionality() != data.n_rows))
+    Log::Fatal << "DecisionStump: presorted index (" << index.Dimensionality()
+        << "x" << index.NumPoints() << ") does not match training data ("
+        << data.n_rows << "x" << data.n_cols << ")!" << std::endl;
+
+  Train<false>(data, labels, index, arma::rowvec());
+}
+
+/**
+ * Constructor. Train on the provided weighted data.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of data.
+ * @param classes Number of distinct classes in labels.
+ * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param weights Weight of each point of data.
+ * @param threads Number of threads used to search the attributes.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const MatType& data,
+                                      const arma::Row<size_t>& labels,
+                                      const size_t classes,
+                                      size_t inpBucketSize,
+                                      const arma::rowvec& weights,
+                                      const size_t threads)
+{
+  numClass = classes;
+  bucketSize = inpBucketSize;
+  SetThreads(threads);
+
+  const PresortedIndex<MatType> index(data);
+  Train<true>(data, labels, index, weights);
+}
+
+/**
+ * Constructor. Train on the provided weighted data, using an already-built
+ * presorted index for it.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of data.
+ * @param classes Number of distinct classes in labels.
+ * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param index Presorted index built from data.
+ * @param weights Weight of each point of data.
+ * @param threads Number of threads used to search the attributes.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const MatType& data,
+                                      const arma::Row<size_t>& labels,
+                                      const size_t classes,
+                                      size_t inpBucketSize,
+                                      const PresortedIndex<MatType>& index,
+                                      const arma::rowvec& weights,
+                                      const size_t threads)
+{
+  numClass = classes;
+  bucketSize = inpBucketSize;
+  SetThreads(threads);
+
+  if ((index.NumPoints() != data.n_cols) ||
+      (index.Dimensionality() != data.n_rows))
+    Log::Fatal << "DecisionStump: presorted index (" << index.Dimensionality()
+        << "x" << index.NumPoints() << ") does not match training data ("
+        << data.n_rows << "x" << data.n_cols << ")!" << std::endl;
+
+  Train<true>(data, labels, index, weights);
+}
+
+/**
+ * Constructor. Train on the provided quantized data, using class-count
+ * histograms instead of sorting.
+ *
+ * @param data Input, quantized training data.
+ * @param labels Labels of data.
+ * @param classes Number of distinct classes in labels.
+ * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param threads Number of threads used to search the attributes.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const QuantizedDataset<MatType>& data,
+                                      const arma::Row<size_t>& labels,
+                                      const size_t classes,
+                                      size_t inpBucketSize,
+                                      const size_t threads)
+{
+  numClass = classes;
+  bucketSize = inpBucketSize;
+  SetThreads(threads);
+
+  TrainHistogram<false>(data, labels, arma::rowvec());
+}
+
+/**
+ * Constructor. Train on the provided weighted quantized data.
+ *
+ * @param data Input, quantized training data.
+ * @param labels Labels of data.
+ * @param classes Number of distinct classes in labels.
+ * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param weights Weight of each point of data.
+ * @param threads Number of threads used to search the attributes.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const QuantizedDataset<MatType>& data,
+                                      const arma::Row<size_t>& labels,
+                                      const size_t classes,
+                                      size_t inpBucketSize,
+                                      const arma::rowvec& weights,
+                                      const size_t threads)
+{
+  numClass = classes;
+  bucketSize = inpBucketSize;
+  SetThreads(threads);
 
-  double gain, bestGain = 0.0;
-  for (int i = 0; i < data.n_rows; i++)
+  TrainHistogram<true>(data, labels, weights);
+}
+
+/**
+ * Constructor. Train on the class-count histograms of a streamed dataset.
+ *
+ * @param histogram Histograms of the training data.
+ * @param inpBucketSize Minimum size of bucket when splitting.
+ * @param threads Number of threads used to search the attributes.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const StreamingHistogram& histogram,
+                                      size_t inpBucketSize,
+                                      const size_t threads)
+{
+  numClass = histogram.NumClasses();
+  bucketSize = inpBucketSize;
+  SetThreads(threads);
+
+  if (histogram.NumPoints() == 0)
+    Log::Fatal << "DecisionStump: the histogram holds no points!" << std::endl;
+
+  // The entropy of the labels, from the total count of each class.
+  const double total = (double) histogram.NumPoints();
+  double rootEntropy = 0.0;
+  for (size_t j = 0; j < numClass; ++j)
+  {
+    const double p1 = histogram.ClassCounts()[j] / total;
+    rootEntropy += (p1 == 0) ? 0 : p1 * log2(p1);
+  }
+
+  // The histograms are already built, so each attribute only needs a sweep
+  // over its bins; see TrainHistogram().
+  arma::vec gains(histogram.Dimensionality());
+  gains.zeros();
+
+  #pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+  for (int i = 0; i < (int) histogram.Dimensionality(); i++)
   {
-    // Go through each attribute of the data.
-    if (IsDistinct<double>(data.row(i)))
+    if (histogram.IsDistinct(i))
+      gains(i) = rootEntropy - SetupSplitHistogram(histogram.BinCounts(i),
+          histogram.BinSizes(i));
+  }
+
+  int bestAtt = 0;
+  double bestGain = 0.0;
+  for (int i = 0; i < (int) histogram.Dimensionality(); i++)
+  {
+    if (gains(i) < bestGain)
     {
-      // For each attribute with non-identical values, treat it as a potential
-      // splitting attribute and calculate entropy if split on it.
-      entropy = SetupSplitAttribute(data.row(i), labels);
-
-      // Log::Debug << "Entropy for attribute " << i << " is " << entropy << ".\n";
-      gain = rootEntropy - entropy;
-      // Find the attribute with the best entropy so that the gain is
-      // maximized.
-
-      // if (entropy < bestEntropy)
-      // Instead of the above rule, we are maximizing gain, which was
-      // what is returned from SetupSplitAttribute.
-      if (gain < bestGain)
-      {
-        bestAtt = i;
-        bestGain = gain;
-      }
+      bestAtt = i;
+      bestGain = gains(i);
     }
   }
   splitAttribute = bestAtt;
 
-  // Once the splitting column/attribute has been decided, train on it.
-  TrainOnAtt<double>(data.row(splitAttribute), labels);
+  TrainOnHistogram(histogram.BinCounts(splitAttribute),
+      histogram.BinSizes(splitAttribute), histogram.BinEdges(splitAttribute));
+}
+
+/**
+ * Constructor. Load a stump from a mapped model file, using the mapped split
+ * values and bin labels in place.
+ *
+ * @param model Mapped model file.
+ * @param threads Number of threads used to classify points.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const MappedStumpModel& model,
+                                      const size_t threads) :
+    split(model.Split(), model.Header().numBins, false, true),
+    // The bin labels are stored as 64-bit integers; where size_t is smaller,
+    // they are copied (and converted below) instead.
+    binLabels((size_t*) model.BinLabels(), model.Header().numBins,
+        sizeof(size_t) != sizeof(uint64_t), sizeof(size_t) == sizeof(uint64_t))
+{
+  numClass = model.Header().numClass;
+  splitAttribute = model.Header().splitAttribute;
+  bucketSize = model.Header().bucketSize;
+  SetThreads(threads);
+
+  if (sizeof(size_t) != sizeof(uint64_t))
+    for (size_t i = 0; i < binLabels.n_elem; ++i)
+      binLabels[i] = model.BinLabels()[i];
+}
+
+/**
+ * Constructor for use as a weak learner in boosting.  Train a new stump on the
+ * given weighted data, with the same parameters as an existing stump.
+ *
+ * @param other Stump to take the training parameters from.
+ * @param data Input, training data.
+ * @param weights Weight of each point of data.
+ * @param labels Labels of data.
+ */
+template<typename MatType>
+DecisionStump<MatType>::DecisionStump(const DecisionStump& other,
+                                      const MatType& data,
+                                      const arma::rowvec& weights,
+                                      const arma::Row<size_t>& labels)
+{
+  numClass = other.numClass;
+  bucketSize = other.bucketSize;
+  numThreads = other.numThreads;
+
+  const PresortedIndex<MatType> index(data);
+  Train<true>(data, labels, index, weights);
 }
 
 /**
@@ -81,37 +303,86 @@ DecisionStump<MatType>::DecisionStump(const MatType& data,
  */
 template<typename MatType>
 void DecisionStump<MatType>::Classify(const MatType& test,
-                                      arma::Row<size_t>& predictedLabels)
+                                      arma::Row<size_t>& predictedLabels) const
 {
-  for (int i = 0; i < test.n_cols; i++)
+  // Gather the splitting attribute of every test point into contiguous memory
+  // first, instead of striding through the (column-major) test matrix.
+  const arma::rowvec values = test.row(splitAttribute);
+
+  // The points are classified in blocks, which are shared out among threads.
+  const size_t blockSize = 256;
+  const int numBlocks = (values.n_elem + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (int block = 0; block < numBlocks; block++)
   {
-    // Determine which bin the test point falls into.
-    // Assume first that it falls into the first bin, then proceed through the
-    // bins until it is known which bin it falls into.
-    int bin = 0;
-    const double val = test(splitAttribute, i);
+    const size_t begin = block * blockSize;
+    const size_t end = std::min(begin + blockSize, (size_t) values.n_elem);
+    const double* val = values.memptr();
 
-    while (bin < split.n_elem - 1)
+    if (split.n_elem <= 16)
     {
-      if (val < split(bin + 1))
-        break;
+      // With few bins, the bin of a point is the number of split values (after
+      // the first) which are not greater than it.  Counting over the whole
+      // block, bin by bin, has no branches and vectorizes across points.
+      size_t bins[blockSize];
+      for (size_t i = begin; i < end; ++i)
+        bins[i - begin] = 0;
 
-      ++bin;
-    }
+      for (size_t j = 1; j < split.n_elem; ++j)
+      {
+        const double splitVal = split[j];
+        for (size_t i = begin; i < end; ++i)
+          bins[i - begin] += !(val[i] < splitVal);
+      }
 
-    predictedLabels(i) = binLabels(bin);
+      for (size_t i = begin; i < end; ++i)
+        predictedLabels[i] = binLabels[bins[i - begin]];
+    }
+    else
+    {
+      for (size_t i = begin; i < end; ++i)
+        predictedLabels[i] = binLabels[Bin(val[i])];
+    }
   }
 }
 
 /**
+ * Find the bin that the given value of the splitting attribute falls into,
+ * with a branchless binary search over the split values.  Values below the
+ * first split value fall into the first bin.
  *
+ * @param val Value of the splitting attribute.
+ */
+template<typename MatType>
+size_t DecisionStump<MatType>::Bin(const double val) const
+{
+  if (split.n_elem <= 1)
+    return 0;
+
+  // Find the number of split values after the first which are not greater than
+  // val.  The comparison is written as !(val < x) so that, as when walking the
+  // bins in order, NaN ends up in the last bin.
+  const double* first = split.memptr() + 1;
+  const double* base = first;
+  size_t n = split.n_elem - 1;
+  while (n > 1)
+  {
+    const size_t half = n / 2;
+    base = (val < base[half]) ? base : base + half;
+    n -= half;
+  }
+
+  return (base - first) + !(val < *base);
+}
+
+/**
+ * Copy constructor.
  *
- *
- *
- *
+ * @param ds Stump to copy.
  */
 template <typename MatType>
-DecisionStump<MatType>::DecisionStump(const DecisionStump<>& ds)
+DecisionStump<MatType>::DecisionStump(const DecisionStump& ds)
 {
   numClass = ds.numClass;
 
@@ -119,6 +390,8 @@ DecisionStump<MatType>::DecisionStump(const DecisionStump<>& ds)
 
   bucketSize = ds.bucketSize;
 
+  numThreads = ds.numThreads;
+
   split = ds.split;
 
   binLabels = ds.binLabels;
@@ -136,87 +409,233 @@ ModifyData(MatType& data)
 
 
 /**
- * Sets up attribute as if it were splitting on it and finds entropy when
- * splitting on attribute.
+ * Save the stump to the given file, in the binary format described by
+ * StumpModelHeader.
  *
- * @param attribute A row from the training data, which might be a candidate for
- *      the splitting attribute.
+ * @param filename File to save to.
+ * @param labelValues Original values of the labels (may be empty).
  */
 template <typename MatType>
-double DecisionStump<MatType>::SetupSplitAttribute(
-    const arma::rowvec& attribute,
-    const arma::Row<size_t>& labels)
+void DecisionStump<MatType>::Save(const std::string& filename,
+                                  const arma::vec& labelValues) const
 {
-  int i, count, begin, end;
-  double entropy = 0.0;
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "DecisionStump::Save(): cannot open '" << filename << "'!"
+        << std::endl;
 
-  // Sort the attribute in order to calculate splitting ranges.
-  arma::rowvec sortedAtt = arma::sort(attribute);
+  StumpModelHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "MLDS", 4);
+  header.version = StumpModelHeader::CurrentVersion;
+  header.numClass = numClass;
+  header.splitAttribute = splitAttribute;
+  header.bucketSize = bucketSize;
+  header.numBins = split.n_elem;
+  header.numLabelValues = labelValues.n_elem;
 
-  // Store the indices of the sorted attribute to build a vector of sorted
-  // labels.  This sort is stable.
-  arma::uvec sortedIndexAtt = arma::stable_sort_index(attribute.t());
+  stream.write((const char*) &header, sizeof(header));
+  stream.write((const char*) split.memptr(), sizeof(double) * split.n_elem);
+  stream.write((const char*) labelValues.memptr(),
+      sizeof(double) * labelValues.n_elem);
+  for (size_t i = 0; i < binLabels.n_elem; ++i)
+  {
+    const uint64_t label = binLabels[i];
+    stream.write((const char*) &label, sizeof(label));
+  }
 
-  arma::Row<size_t> sortedLabels(attribute.n_elem);
-  sortedLabels.fill(0);
+  if (!stream.good())
+    Log::Fatal << "DecisionStump::Save(): error writing '" << filename << "'!"
+        << std::endl;
+}
 
-  for (i = 0; i < attribute.n_elem; i++)
-    sortedLabels(i) = labels(sortedIndexAtt(i));
+/**
+ * Set the number of threads used during training.
+ *
+ * @param threads Requested number of threads; 0 means the OpenMP default.
+ */
+template <typename MatType>
+void DecisionStump<MatType>::SetThreads(const size_t threads)
+{
+#ifdef _OPENMP
+  numThreads = (threads == 0) ? omp_get_max_threads() : (int) threads;
+#else
+  numThreads = 1;
+#endif
+}
 
-  i = 0;
-  count = 0;
+/**
+ * Find the best splitting attribute using the given presorted index, and then
+ * train on it.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of data.
+ * @param index Presorted index built from data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
+ */
+template <typename MatType>
+template <bool UseWeights>
+void DecisionStump<MatType>::Train(const MatType& data,
+                                   const arma::Row<size_t>& labels,
+                                   const PresortedIndex<MatType>& index,
+                                   const arma::rowvec& weights)
+{
+  if (UseWeights && (weights.n_elem != labels.n_elem))
+    Log::Fatal << "DecisionStump: number of weights (" << weights.n_elem
+        << ") does not match number of labels (" << labels.n_elem << ")!"
+        << std::endl;
 
-  // This splits the sorted into buckets of size greater than or equal to
-  // inpBucketSize.
-  while (i < sortedLabels.n_elem)
+  // If classLabels are not all identical, proceed with training.
+  int bestAtt = 0;
+  const double rootEntropy = UseWeights ?
+      CalculateEntropy<size_t>(labels.subvec(0, labels.n_elem - 1),
+                               weights.subvec(0, weights.n_elem - 1)) :
+      CalculateEntropy<size_t>(labels.subvec(0, labels.n_elem - 1));
+
+  // The attributes are independent, so they are searched in parallel.  Each
+  // gain is stored, and the best one is picked afterwards in attribute order,
+  // so the result does not depend on the number of threads.
+  arma::vec gains(data.n_rows);
+  gains.zeros();
+
+  const double totalWeight = UseWeights ? arma::accu(weights) :
+      (double) labels.n_elem;
+
+  #pragma omp parallel num_threads(numThreads)
   {
-    count++;
-    if (i == sortedLabels.n_elem - 1)
+    // Running class counts for SetupSplitAttribute(), allocated once per
+    // thread and reused for every attribute.
+    arma::vec classCounts(numClass);
+    classCounts.zeros();
+
+    #pragma omp for schedule(dynamic)
+    for (int i = 0; i < (int) data.n_rows; i++)
+    {
+      // Go through each attribute of the data.
+      if (index.IsDistinct(i))
+      {
+        // For each attribute with non-identical values, treat it as a
+        // potential splitting attribute and calculate entropy if split on it.
+        const double entropy = SetupSplitAttribute<UseWeights>(
+            index.Order().col(i), labels, weights, totalWeight, classCounts);
+
+        // Log::Debug << "Entropy for attribute " << i << " is " << entropy << ".\n";
+        gains(i) = rootEntropy - entropy;
+      }
+    }
+  }
+
+  // Find the attribute with the best entropy so that the gain is maximized.
+  // if (entropy < bestEntropy)
+  // Instead of the above rule, we are maximizing gain, which was what is
+  // returned from SetupSplitAttribute.
+  double bestGain = 0.0;
+  for (int i = 0; i < (int) data.n_rows; i++)
+  {
+    if (gains(i) < bestGain)
+    {
+      bestAtt = i;
+      bestGain = gains(i);
+    }
+  }
+  splitAttribute = bestAtt;
+
+  // Once the splitting column/attribute has been decided, train on it.
+  TrainOnAtt<UseWeights>(data.row(splitAttribute),
+      index.Order().col(splitAttribute), labels, weights);
+}
+
+/**
+ * Sets up attribute as if it were splitting on it and finds entropy when
+ * splitting on attribute.
+ *
+ * The points are visited once, in sorted order, and added to the running class
+ * counts of the current bucket; when a bucket ends its entropy is taken from
+ * those counts, which are reset for the next bucket.  Nothing is allocated.
+ *
+ * @param sortedOrder Indices of the points of a candidate splitting attribute,
+ *      in sorted order.
+ * @param labels Labels of data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
+ * @param totalWeight Total weight of all points (or the number of points if
+ *      UseWeights is false).
+ * @param classCounts Scratch vector of length numClass, which must be all zeros
+ *      on entry; it is all zeros again on return.
+ */
+template <typename MatType>
+template <bool UseWeights>
+double DecisionStump<MatType>::SetupSplitAttribute(
+    const arma::subview_col<arma::uword>& sortedOrder,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& weights,
+    const double totalWeight,
+    arma::vec& classCounts)
+{
+  const size_t numPoints = sortedOrder.n_elem;
+  double entropy = 0.0;
+  double bucketWeight = 0.0;
+  size_t i = 0, begin = 0, end;
+
+  // This splits the sorted points into buckets of size greater than or equal
+  // to inpBucketSize, in the same way that TrainOnAtt() does.
+  while (i < numPoints)
+  {
+    const size_t label = labels[sortedOrder[i]];
+    const double weight = UseWeights ? weights[sortedOrder[i]] : 1.0;
+    classCounts[label] += weight;
+    bucketWeight += weight;
+
+    if (i == numPoints - 1)
     {
       // If we're at the end, then don't worry about the bucket size; just take
       // this as the last bin.
-      begin = i - count + 1;
       end = i;
-
-      // Use ratioEl to calculate the ratio of elements in this split.
-      const double ratioEl = ((double) (end - begin + 1) / sortedLabels.n_elem);
-
-      entropy += ratioEl * CalculateEntropy<size_t>(
-          sortedLabels.subvec(begin, end));
-      i++;
     }
-    else if (sortedLabels(i) != sortedLabels(i + 1))
+    else if (label != labels[sortedOrder[i + 1]])
     {
-      // If we're not at the last element of sortedLabels, then check whether
-      // count is less than the current bucket size.
-      if (count < bucketSize)
-      {
-        // If it is, then take the minimum bucket size anyways.
-        // This is where the inpBucketSize comes into use.
-        // This makes sure there isn't a bucket for every change in labels.
-        begin = i - count + 1;
-        end = begin + bucketSize - 1;
+      end = i;
 
-        if (end > sortedLabels.n_elem - 1)
-          end = sortedLabels.n_elem - 1;
-      }
-      else
+      // If the bucket is smaller than the minimum bucket size, then take the
+      // minimum bucket size anyways, adding the points after i.  This makes
+      // sure there isn't a bucket for every change in labels.
+      if (i - begin + 1 < bucketSize)
       {
-        // If it is not, then take the bucket size as the value of count.
-        begin = i - count + 1;
-        end = i;
+        end = std::min(begin + bucketSize - 1, numPoints - 1);
+        for (size_t j = i + 1; j <= end; ++j)
+        {
+          const double extraWeight = UseWeights ? weights[sortedOrder[j]] : 1.0;
+          classCounts[labels[sortedOrder[j]]] += extraWeight;
+          bucketWeight += extraWeight;
+        }
       }
-      const double ratioEl = ((double) (end - begin + 1) / sortedLabels.n_elem);
-
-      entropy += ratioEl * CalculateEntropy<size_t>(
-          sortedLabels.subvec(begin, end));
-
-      i = end + 1;
-      count = 0;
     }
     else
+    {
       i++;
+      continue;
+    }
+
+    // The bucket [begin, end] is complete; add its entropy, weighted by the
+    // ratio of elements (or of the total weight) in it, and reset the counts.
+    const double bucketTotal = UseWeights ? bucketWeight :
+        (double) (end - begin + 1);
+    double bucketEntropy = 0.0;
+    for (size_t j = 0; j < numClass; ++j)
+    {
+      if (classCounts[j] != 0)
+      {
+        const double p1 = classCounts[j] / bucketTotal;
+        bucketEntropy += p1 * log2(p1);
+        classCounts[j] = 0;
+      }
+    }
+    entropy += (bucketTotal / totalWeight) * bucketEntropy;
+
+    begin = end + 1;
+    i = end + 1;
+    bucketWeight = 0.0;
   }
+
   return entropy;
 }
 
@@ -226,26 +645,36 @@ double DecisionStump<MatType>::SetupSplitAttribute(
  *
  * @param attribute Attribute is the attribute decided by the constructor on
  *      which we now train the decision stump.
+ * @param sortedOrder Indices of the points of attribute, in sorted order.
+ * @param labels Labels of data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
  */
 template <typename MatType>
-template <typename rType>
-void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
-                                        const arma::Row<size_t>& labels)
+template <bool UseWeights>
+void DecisionStump<MatType>::TrainOnAtt(
+    const arma::rowvec& attribute,
+    const arma::subview_col<arma::uword>& sortedOrder,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& weights)
 {
   int i, count, begin, end;
 
-  arma::rowvec sortedSplitAtt = arma::sort(attribute);
-  arma::uvec sortedSplitIndexAtt = arma::stable_sort_index(attribute.t());
+  arma::rowvec sortedSplitAtt(attribute.n_elem);
   arma::Row<size_t> sortedLabels(attribute.n_elem);
-  sortedLabels.fill(0);
-  arma::vec tempSplit;
-  arma::Row<size_t> tempLabel;
+  arma::rowvec sortedWeights;
+  if (UseWeights)
+    sortedWeights.set_size(attribute.n_elem);
 
   for (i = 0; i < attribute.n_elem; i++)
-    sortedLabels(i) = labels(sortedSplitIndexAtt(i));
+  {
+    sortedSplitAtt(i) = attribute(sortedOrder[i]);
+    sortedLabels(i) = labels(sortedOrder[i]);
+    if (UseWeights)
+      sortedWeights(i) = weights(sortedOrder[i]);
+  }
 
   arma::rowvec subCols;
-  rType mostFreq;
+  double mostFreq;
   i = 0;
   count = 0;
   while (i < sortedLabels.n_elem)
@@ -261,7 +690,11 @@ void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
 
       subCols = sortedLabels.cols(begin, end) + zSubCols;
 
-      mostFreq = CountMostFreq<double>(subCols);
+      if (UseWeights)
+        mostFreq = CountMostFreq<double>(subCols,
+            sortedWeights.cols(begin, end));
+      else
+        mostFreq = CountMostFreq<double>(subCols);
 
       split.resize(split.n_elem + 1);
       split(split.n_elem - 1) = sortedSplitAtt(begin);
@@ -291,9 +724,13 @@ void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
 
       subCols = sortedLabels.cols(begin, end) + zSubCols;
 
-      // Find the most frequent element in subCols so as to assign a label to
-      // the bucket of subCols.
-      mostFreq = CountMostFreq<double>(subCols);
+      // Find the most frequent (or heaviest) element in subCols so as to assign
+      // a label to the bucket of subCols.
+      if (UseWeights)
+        mostFreq = CountMostFreq<double>(subCols,
+            sortedWeights.cols(begin, end));
+      else
+        mostFreq = CountMostFreq<double>(subCols);
 
       split.resize(split.n_elem + 1);
       split(split.n_elem - 1) = sortedSplitAtt(begin);
@@ -312,6 +749,385 @@ void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
   MergeRanges();
 }
 
+/**
+ * Sets up an attribute of sparse data as if it were splitting on it and finds
+ * entropy when splitting on it; if train is true, the split values and bin
+ * labels are set up too.
+ *
+ * The sorted points are walked as a sequence of units: each nonzero is a unit
+ * of its own, and the implicit zeros, which all have the same value, form a
+ * single unit between the negative and the positive nonzeros.  The class counts
+ * of that unit are whatever the nonzeros leave of the total class counts, so
+ * the zeros are never visited one by one.  The units are then split into
+ * buckets just as SetupSplitAttribute() splits the points, except that the
+ * zero block is never split and its label is its most frequent class.
+ *
+ * @param index Presorted index built from the sparse training data.
+ * @param attribute Candidate splitting attribute.
+ * @param labels Labels of data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
+ * @param totalCounts Total (weighted) count of each class.
+ * @param totalWeight Total weight of all points (or the number of points if
+ *      UseWeights is false).
+ * @param classCounts Scratch vector of length numClass, which must be all zeros
+ *      on entry; it is all zeros again on return.
+ * @param zeroCounts Scratch vector of length numClass.
+ * @param train Whether or not to set up the split values and bin labels.
+ */
+template <typename MatType>
+template <bool UseWeights>
+double DecisionStump<MatType>::SweepSparseAttribute(
+    const PresortedIndex<arma::sp_mat>& index,
+    const size_t attribute,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& weights,
+    const arma::vec& totalCounts,
+    const double totalWeight,
+    arma::vec& classCounts,
+    arma::vec& zeroCounts,
+    const bool train)
+{
+  const arma::uword* points = index.Points().memptr() +
+      index.Offsets()[attribute];
+  const double* values = index.Values().memptr() + index.Offsets()[attribute];
+  const size_t numNonzeros = index.NumNonzeros(attribute);
+  const size_t numZeros = index.NumPoints() - numNonzeros;
+
+  // Find the class counts of the zero block from those of the nonzeros.
+  size_t zeroLabel = 0;
+  double zeroWeight = 0.0;
+  if (numZeros > 0)
+  {
+    zeroCounts = totalCounts;
+    for (size_t k = 0; k < numNonzeros; ++k)
+      zeroCounts[labels[points[k]]] -= UseWeights ? weights[points[k]] : 1.0;
+
+    for (size_t j = 0; j < numClass; ++j)
+    {
+      // Rounding may leave a tiny negative weight behind.
+      if (zeroCounts[j] < 0)
+        zeroCounts[j] = 0;
+      zeroWeight += zeroCounts[j];
+    }
+    zeroLabel = MajorityClass(zeroCounts, 0);
+  }
+
+  // Units before zeroUnit are nonzeros k; units after it are nonzeros k - 1.
+  const size_t numUnits = numNonzeros + ((numZeros > 0) ? 1 : 0);
+  const size_t zeroUnit = (numZeros > 0) ? index.NumNegative(attribute) :
+      numUnits;
+
+  double entropy = 0.0;
+  double bucketWeight = 0.0;
+  size_t bucketPoints = 0;
+  size_t k = 0, begin = 0;
+  while (k < numUnits)
+  {
+    // Add unit k (and any units needed to fill the bucket) to the bucket.
+    size_t end = k;
+    size_t label;
+    bool close = false;
+    do
+    {
+      if (end == zeroUnit)
+      {
+        for (size_t j = 0; j < numClass; ++j)
+          classCounts[j] += zeroCounts[j];
+        bucketWeight += zeroWeight;
+        bucketPoints += numZeros;
+        label = zeroLabel;
+      }
+      else
+      {
+        const size_t point = points[(end > zeroUnit) ? end - 1 : end];
+        const double weight = UseWeights ? weights[point] : 1.0;
+        label = labels[point];
+        classCounts[label] += weight;
+        bucketWeight += weight;
+        bucketPoints++;
+      }
+
+      if (end == k)
+      {
+        if (k == numUnits - 1)
+        {
+          close = true;
+        }
+        else
+        {
+          const size_t nextLabel = (k + 1 == zeroUnit) ? zeroLabel :
+              labels[points[(k + 1 > zeroUnit) ? k : k + 1]];
+          close = (label != nextLabel);
+        }
+
+        if (!close)
+          break;
+      }
+
+      // If the bucket is smaller than the minimum bucket size, then keep adding
+      // units until it is large enough.
+      if ((bucketPoints >= bucketSize) || (end == numUnits - 1))
+        break;
+      ++end;
+    } while (true);
+
+    if (!close)
+    {
+      k++;
+      continue;
+    }
+
+    // The bucket [begin, end] is complete; add its entropy, weighted by the
+    // ratio of elements (or of the total weight) in it, and reset the counts.
+    if (train)
+    {
+      split.resize(split.n_elem + 1);
+      split(split.n_elem - 1) = (begin == zeroUnit) ? 0.0 :
+          values[(begin > zeroUnit) ? begin - 1 : begin];
+      binLabels.resize(binLabels.n_elem + 1);
+      binLabels(binLabels.n_elem - 1) = MajorityClass(classCounts, 0);
+    }
+
+    const double bucketTotal = UseWeights ? bucketWeight :
+        (double) bucketPoints;
+    double bucketEntropy = 0.0;
+    for (size_t j = 0; j < numClass; ++j)
+    {
+      if (classCounts[j] != 0)
+      {
+        const double p1 = classCounts[j] / bucketTotal;
+        bucketEntropy += p1 * log2(p1);
+        classCounts[j] = 0;
+      }
+    }
+    entropy += (bucketTotal / totalWeight) * bucketEntropy;
+
+    begin = end + 1;
+    k = end + 1;
+    bucketWeight = 0.0;
+    bucketPoints = 0;
+  }
+
+  return entropy;
+}
+
+/**
+ * Find the best splitting attribute from class-count histograms of the
+ * quantized data, and then train on it.
+ *
+ * @param data Input, quantized training data.
+ * @param labels Labels of data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
+ */
+template <typename MatType>
+template <bool UseWeights>
+void DecisionStump<MatType>::TrainHistogram(
+    const QuantizedDataset<MatType>& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& weights)
+{
+  if (UseWeights && (weights.n_elem != labels.n_elem))
+    Log::Fatal << "DecisionStump: number of weights (" << weights.n_elem
+        << ") does not match number of labels (" << labels.n_elem << ")!"
+        << std::endl;
+
+  int bestAtt = 0;
+  const double rootEntropy = UseWeights ?
+      CalculateEntropy<size_t>(labels.subvec(0, labels.n_elem - 1),
+                               weights.subvec(0, weights.n_elem - 1)) :
+      CalculateEntropy<size_t>(labels.subvec(0, labels.n_elem - 1));
+
+  // Search the attributes in parallel; see Train().
+  arma::vec gains(data.Dimensionality());
+  gains.zeros();
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+    // These are reused for each attribute searched by this thread.
+    arma::mat binCounts;
+    arma::vec binSizes;
+
+    #pragma omp for schedule(dynamic)
+    for (int i = 0; i < (int) data.Dimensionality(); i++)
+    {
+      if (data.IsDistinct(i))
+      {
+        BuildHistogram<UseWeights>(data, i, labels, weights, binCounts,
+            binSizes);
+        gains(i) = rootEntropy - SetupSplitHistogram(binCounts, binSizes);
+      }
+    }
+  }
+
+  // As in Train(), "entropy" here is the negative entropy, so the smallest gain
+  // is the best.
+  double bestGain = 0.0;
+  for (int i = 0; i < (int) data.Dimensionality(); i++)
+  {
+    if (gains(i) < bestGain)
+    {
+      bestAtt = i;
+      bestGain = gains(i);
+    }
+  }
+  splitAttribute = bestAtt;
+
+  arma::mat binCounts;
+  arma::vec binSizes;
+  BuildHistogram<UseWeights>(data, splitAttribute, labels, weights, binCounts,
+      binSizes);
+  TrainOnHistogram(binCounts, binSizes, data.BinEdges(splitAttribute));
+}
+
+/**
+ * Count the points of each class falling into each bin of an attribute of the
+ * quantized data.
+ *
+ * @param data Input, quantized training data.
+ * @param attribute Attribute to build the histogram of.
+ * @param labels Labels of data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
+ * @param binCounts Output (weighted) class counts of each bin.
+ * @param binSizes Output number of points in each bin.
+ */
+template <typename MatType>
+template <bool UseWeights>
+void DecisionStump<MatType>::BuildHistogram(
+    const QuantizedDataset<MatType>& data,
+    const size_t attribute,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& weights,
+    arma::mat& binCounts,
+    arma::vec& binSizes)
+{
+  binCounts.zeros(numClass, data.NumBins(attribute));
+  binSizes.zeros(data.NumBins(attribute));
+
+  const unsigned char* codes = data.Codes().colptr(attribute);
+  for (size_t j = 0; j < data.NumPoints(); ++j)
+  {
+    binCounts(labels(j), codes[j]) += UseWeights ? weights(j) : 1.0;
+    binSizes(codes[j])++;
+  }
+}
+
+/**
+ * Finds the entropy when splitting on an attribute, given its histogram.
+ *
+ * @param binCounts Class counts of each bin of the attribute.
+ * @param binSizes Number of points in each bin of the attribute.
+ */
+template <typename MatType>
+double DecisionStump<MatType>::SetupSplitHistogram(const arma::mat& binCounts,
+                                                   const arma::vec& binSizes)
+{
+  double entropy = 0.0;
+  const double total = arma::accu(binCounts);
+
+  arma::vec bucketCounts;
+  size_t begin = 0;
+  while (begin < binCounts.n_cols)
+  {
+    begin = NextHistogramBucket(binCounts, binSizes, begin, bucketCounts);
+
+    const double bucketTotal = arma::accu(bucketCounts);
+    double bucketEntropy = 0.0;
+    for (size_t j = 0; j < numClass; ++j)
+    {
+      const double p1 = bucketCounts(j) / bucketTotal;
+      bucketEntropy += (p1 == 0) ? 0 : p1 * log2(p1);
+    }
+
+    entropy += (bucketTotal / total) * bucketEntropy;
+  }
+
+  return entropy;
+}
+
+/**
+ * After having decided the attribute on which to split, train on its
+ * histogram.
+ *
+ * @param binCounts Class counts of each bin of the attribute.
+ * @param binSizes Number of points in each bin of the attribute.
+ * @param binEdges Lower edges of each bin of the attribute.
+ */
+template <typename MatType>
+void DecisionStump<MatType>::TrainOnHistogram(const arma::mat& binCounts,
+                                              const arma::vec& binSizes,
+                                              const arma::vec& binEdges)
+{
+  arma::vec bucketCounts;
+  size_t begin = 0;
+  while (begin < binCounts.n_cols)
+  {
+    split.resize(split.n_elem + 1);
+    split(split.n_elem - 1) = binEdges(begin);
+
+    begin = NextHistogramBucket(binCounts, binSizes, begin, bucketCounts);
+
+    binLabels.resize(binLabels.n_elem + 1);
+    binLabels(binLabels.n_elem - 1) = MajorityClass(bucketCounts, 0);
+  }
+
+  // Now trim the split matrix so that buckets one after the after which point
+  // to the same classLabel are merged as one big bucket.
+  MergeRanges();
+}
+
+/**
+ * Group the bins of a histogram into a bucket, starting at the given bin.
+ *
+ * @param binCounts Class counts of each bin of the attribute.
+ * @param binSizes Number of points in each bin of the attribute.
+ * @param begin First bin of the bucket.
+ * @param bucketCounts Output class counts of the bucket.
+ * @return One past the last bin of the bucket.
+ */
+template <typename MatType>
+size_t DecisionStump<MatType>::NextHistogramBucket(const arma::mat& binCounts,
+                                                   const arma::vec& binSizes,
+                                                   const size_t begin,
+                                                   arma::vec& bucketCounts)
+{
+  bucketCounts.zeros(numClass);
+  double count = 0;
+
+  size_t end = begin;
+  while (end < binCounts.n_cols)
+  {
+    bucketCounts += binCounts.col(end);
+    count += binSizes(end);
+    ++end;
+
+    // Only end the bucket where the class changes, and if it is big enough.
+    if ((end < binCounts.n_cols) && (count >= bucketSize) &&
+        (MajorityClass(binCounts, end - 1) != MajorityClass(binCounts, end)))
+      break;
+  }
+
+  return end;
+}
+
+/**
+ * Find the class with the largest count in the given column of counts.
+ *
+ * @param counts Matrix of class counts.
+ * @param col Column of counts to look at.
+ */
+template <typename MatType>
+size_t DecisionStump<MatType>::MajorityClass(const arma::mat& counts,
+                                             const size_t col)
+{
+  const double* colCounts = counts.colptr(col);
+  size_t best = 0;
+  for (size_t j = 1; j < counts.n_rows; ++j)
+    if (colCounts[j] > colCounts[best])
+      best = j;
+
+  return best;
+}
+
 /**
  * After the "split" matrix has been set up, merge ranges with identical class
  * labels.
@@ -377,19 +1193,30 @@ rType DecisionStump<MatType>::CountMostFreq(const arma::Row<rType>& subCols)
 }
 
 /**
- * Returns 1 if all the values of featureRow are not same.
+ * Find the element of subCols with the largest total weight.  Ties go to the
+ * smallest element.
  *
- * @param featureRow The attribute which is checked for identical values.
+ * @param subCols The vector of class labels in which to find the heaviest
+ *     element.
+ * @param weights The weight of each element of subCols.
  */
 template <typename MatType>
 template <typename rType>
-int DecisionStump<MatType>::IsDistinct(const arma::Row<rType>& featureRow)
+rType DecisionStump<MatType>::CountMostFreq(const arma::Row<rType>& subCols,
+                                            const arma::rowvec& weights)
 {
-  rType val = featureRow(0);
-  for (size_t i = 1; i < featureRow.n_elem; ++i)
-    if (val != featureRow(i))
-      return 1;
-  return 0;
+  arma::vec classWeights(numClass);
+  classWeights.zeros();
+
+  for (size_t i = 0; i < subCols.n_elem; ++i)
+    classWeights((size_t) subCols(i)) += weights(i);
+
+  size_t element = 0;
+  for (size_t j = 1; j < numClass; ++j)
+    if (classWeights(j) > classWeights(element))
+      element = j;
+
+  return (rType) element;
 }
 
 /**
@@ -423,6 +1250,147 @@ double DecisionStump<MatType>::CalculateEntropy(arma::subview_row<LabelType> lab
   return entropy;
 }
 
+/**
+ * Calculate the entropy of the given weighted labels.
+ *
+ * @param labels Corresponding labels of the attribute.
+ * @param weights Weight of each label.
+ */
+template<typename MatType>
+template<typename AttType, typename LabelType>
+double DecisionStump<MatType>::CalculateEntropy(
+    arma::subview_row<LabelType> labels,
+    arma::subview_row<double> weights)
+{
+  double entropy = 0.0;
+  size_t j;
+
+  arma::rowvec classWeights(numClass);
+  classWeights.fill(0.0);
+
+  // Populate classWeights with the total weight of each class.
+  for (j = 0; j < labels.n_elem; j++)
+    classWeights(labels(j)) += weights(j);
+
+  const double totalWeight = arma::accu(classWeights);
+  if (totalWeight == 0.0)
+    return 0.0;
+
+  for (j = 0; j < numClass; j++)
+  {
+    const double p1 = classWeights(j) / totalWeight;
+
+    entropy += (p1 == 0) ? 0 : p1 * log2(p1);
+  }
+
+  return entropy;
+}
+
+/**
+ * Find the best splitting attribute of sparse data, and then train on it.  The
+ * presorted index only holds the nonzeros, and SweepSparseAttribute() handles
+ * the implicit zeros of each attribute as a block, so this costs O(nnz) for
+ * the attribute search (plus O(n) for the class totals).
+ *
+ * @param data Input, sparse training data.
+ * @param labels Labels of data.
+ * @param index Presorted index built from data.
+ * @param weights Weight of each point (ignored if UseWeights is false).
+ */
+template <>
+template <bool UseWeights>
+void DecisionStump<arma::sp_mat>::Train(
+    const arma::sp_mat& data,
+    const arma::Row<size_t>& labels,
+    const PresortedIndex<arma::sp_mat>& index,
+    const arma::rowvec& weights)
+{
+  if (UseWeights && (weights.n_elem != labels.n_elem))
+    Log::Fatal << "DecisionStump: number of weights (" << weights.n_elem
+        << ") does not match number of labels (" << labels.n_elem << ")!"
+        << std::endl;
+
+  int bestAtt = 0;
+  const double rootEntropy = UseWeights ?
+      CalculateEntropy<size_t>(labels.subvec(0, labels.n_elem - 1),
+                               weights.subvec(0, weights.n_elem - 1)) :
+      CalculateEntropy<size_t>(labels.subvec(0, labels.n_elem - 1));
+
+  // The total count of each class, from which the counts of the implicit zeros
+  // of each attribute are found.
+  arma::vec totalCounts(numClass);
+  totalCounts.zeros();
+  for (size_t j = 0; j < labels.n_elem; ++j)
+    totalCounts[labels[j]] += UseWeights ? weights[j] : 1.0;
+
+  const double totalWeight = UseWeights ? arma::accu(weights) :
+      (double) labels.n_elem;
+
+  arma::vec gains(data.n_rows);
+  gains.zeros();
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+    arma::vec classCounts(numClass);
+    classCounts.zeros();
+    arma::vec zeroCounts(numClass);
+
+    #pragma omp for schedule(dynamic)
+    for (int i = 0; i < (int) data.n_rows; i++)
+    {
+      if (index.IsDistinct(i))
+        gains(i) = rootEntropy - SweepSparseAttribute<UseWeights>(index, i,
+            labels, weights, totalCounts, totalWeight, classCounts, zeroCounts,
+            false);
+    }
+  }
+
+  // Pick the best attribute in attribute order, as with dense data.
+  double bestGain = 0.0;
+  for (int i = 0; i < (int) data.n_rows; i++)
+  {
+    if (gains(i) < bestGain)
+    {
+      bestAtt = i;
+      bestGain = gains(i);
+    }
+  }
+  splitAttribute = bestAtt;
+
+  // Once the splitting attribute has been decided, train on it.
+  arma::vec classCounts(numClass);
+  classCounts.zeros();
+  arma::vec zeroCounts(numClass);
+  SweepSparseAttribute<UseWeights>(index, splitAttribute, labels, weights,
+      totalCounts, totalWeight, classCounts, zeroCounts, true);
+
+  // Now trim the split matrix so that buckets one after the after which point
+  // to the same classLabel are merged as one big bucket.
+  MergeRanges();
+}
+
+/**
+ * Classification function for sparse data.  Every point whose splitting
+ * attribute is zero takes the label of the bin holding zero, so only the
+ * nonzeros of the test data need to be visited.
+ *
+ * @param test Testing data or data to classify.
+ * @param predictedLabels Vector to store the predicted classes after
+ *      classifying test
+ */
+template <>
+inline void DecisionStump<arma::sp_mat>::Classify(
+    const arma::sp_mat& test,
+    arma::Row<size_t>& predictedLabels) const
+{
+  predictedLabels.set_size(test.n_cols);
+  predictedLabels.fill(binLabels[Bin(0.0)]);
+
+  for (arma::sp_mat::const_iterator it = test.begin(); it != test.end(); ++it)
+    if (it.row() == (arma::uword) splitAttribute)
+      predictedLabels[it.col()] = binLabels[Bin(*it)];
+}
+
 }; // namespace decision_stump
 }; // namespace mlpack
 
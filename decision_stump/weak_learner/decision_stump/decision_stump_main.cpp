@@ -7,6 +7,9 @@
 
 #include <mlpack/core.hpp>
 #include "decision_stump.hpp"
+#include "chunked_reader.hpp"
+
+#include <map>
 
 using namespace mlpack;
 using namespace mlpack::decision_stump;
@@ -17,62 +20,141 @@ PROGRAM_INFO("Decision Stump","This program implements a decision stump, "
     "a single level decision tree, on the given training data set. "
     "Default size of buckets is 6");
 
-// necessary parameters
-PARAM_STRING_REQ("train_file", "A file containing the training set.", "tr");
-PARAM_STRING_REQ("labels_file", "A file containing labels for the training set.",
-  "l");
-PARAM_STRING_REQ("test_file", "A file containing the test set.", "te");
-PARAM_STRING_REQ("num_classes","The number of classes","c");
+// training parameters (needed unless --input_model is given)
+PARAM_STRING("train_file", "A file containing the training set.", "tr", "");
+PARAM_STRING("labels_file", "A file containing labels for the training set.",
+  "l", "");
+PARAM_INT("num_classes", "The number of classes.", "c", 0);
+
+// model parameters (optional)
+PARAM_STRING("input_model", "If given, load the stump from this binary model "
+    "file (memory-mapped) instead of training it.", "m", "");
+PARAM_STRING("output_model", "If given, save the stump to this binary model "
+    "file.", "M", "");
 
-// output parameters (optional)
+// testing parameters (optional)
+PARAM_STRING("test_file", "A file containing the test set.", "te", "");
 PARAM_STRING("output", "The file in which the predicted labels for the test set"
     " will be written.", "o", "output.csv");
 
 PARAM_INT("bucket_size","The size of ranges/buckets to be used while splitting the decision stump.","b", 6);
+PARAM_INT("histogram_bins", "If nonzero, quantize each attribute into at most "
+    "this many bins (up to 256) and train with class-count histograms instead "
+    "of sorting.", "H", 0);
+PARAM_INT("threads", "The number of threads used to search attributes while "
+    "training (0 uses all available cores).", "j", 0);
+PARAM_INT("chunk_size", "If nonzero, the training set and labels are not "
+    "loaded into memory, but streamed in chunks of this many points (one point "
+    "per line) and trained on with class-count histograms of at most "
+    "--histogram_bins bins (256 if not given).", "k", 0);
+PARAM_INT("sketch_size", "The number of points sampled to find the histogram "
+    "bins when --chunk_size is given.", "s", 65536);
 
-int main(int argc, char *argv[])
+/**
+ * Train a decision stump on a training set which is streamed from disk in
+ * chunks, in two passes: the first samples the points to find the histogram
+ * bins and finds the label mappings, and the second counts the points of each
+ * class in each bin.  The labels are normalized in the same way as
+ * data::NormalizeLabels() does.
+ */
+DecisionStump<> TrainStreaming(const string& trainingDataFilename,
+                               const string& labelsFilename,
+                               const size_t numClasses,
+                               const size_t bucketSize,
+                               const size_t histogramBins,
+                               const size_t threads,
+                               vec& mappings)
 {
-  CLI::ParseCommandLine(argc, argv);
+  const size_t chunkSize = CLI::GetParam<int>("chunk_size");
+  const size_t sketchSize = CLI::GetParam<int>("sketch_size");
 
-  const string trainingDataFilename = CLI::GetParam<string>("train_file");
-  mat trainingData;
-  data::Load(trainingDataFilename, trainingData, true);
+  ChunkedReader trainingReader(trainingDataFilename, chunkSize);
+  ChunkedReader labelsReader(labelsFilename, chunkSize);
+  if (labelsReader.Dimensionality() != 1)
+    Log::Fatal << "Labels file must have one label per line when "
+        << "--chunk_size is given!" << std::endl;
 
-  const string labelsFilename = CLI::GetParam<string>("labels_file");
-  // Load labels.
-  mat labelsIn;
-  data::Load(labelsFilename, labelsIn, true);
+  StreamingHistogram histogram(trainingReader.Dimensionality(), numClasses,
+      (histogramBins == 0) ? 256 : histogramBins, sketchSize);
 
-  // helpers for normalizing the labels
-  Col<size_t> labels;
-  vec mappings;
+  // First pass: sketch the data and find the label mappings.
+  std::map<double, size_t> labelMap;
+  std::vector<double> labelValues;
+  mat chunk, labelsChunk;
+  while (trainingReader.Next(chunk))
+  {
+    if (!labelsReader.Next(labelsChunk) || labelsChunk.n_cols != chunk.n_cols)
+      Log::Fatal << "Labels file has fewer labels than the training set has "
+          << "points!" << std::endl;
 
-  // Do the labels need to be transposed?
-  if (labelsIn.n_rows == 1)
-    labelsIn = labelsIn.t();
+    histogram.Sketch(chunk);
+    for (size_t i = 0; i < labelsChunk.n_cols; ++i)
+    {
+      if (labelMap.count(labelsChunk[i]) == 0)
+      {
+        labelMap[labelsChunk[i]] = labelValues.size();
+        labelValues.push_back(labelsChunk[i]);
+      }
+    }
+  }
+  if (labelsReader.Next(labelsChunk))
+    Log::Fatal << "Labels file has more labels than the training set has "
+        << "points!" << std::endl;
 
-  size_t inpBucketSize = CLI::GetParam<int>("bucket_size");
+  mappings = conv_to<vec>::from(labelValues);
+  histogram.ComputeBinEdges();
 
-  // normalize the labels
-  data::NormalizeLabels(labelsIn.unsafe_col(0), labels, mappings);
+  // Second pass: count the points of each class in each bin.
+  trainingReader.Reset();
+  labelsReader.Reset();
+  Row<size_t> labels;
+  while (trainingReader.Next(chunk))
+  {
+    labelsReader.Next(labelsChunk);
+    labels.set_size(labelsChunk.n_cols);
+    for (size_t i = 0; i < labelsChunk.n_cols; ++i)
+      labels[i] = labelMap[labelsChunk[i]];
+
+    histogram.Count(chunk, labels);
+  }
+
+  Log::Info << "Streamed " << histogram.NumPoints() << " training points."
+      << std::endl;
+
+  return DecisionStump<>(histogram, bucketSize, threads);
+}
+
+/**
+ * Save the stump if --output_model is given, and classify the test set if
+ * --test_file is given.
+ *
+ * @param ds Trained or loaded stump.
+ * @param mappings Original values of the labels.
+ * @param dimensionality Dimensionality of the training set (0 if unknown).
+ */
+void SaveAndClassify(DecisionStump<>& ds,
+                     const vec& mappings,
+                     const size_t dimensionality)
+{
+  const string outputModelFilename = CLI::GetParam<string>("output_model");
+  if (outputModelFilename != "")
+    ds.Save(outputModelFilename, mappings);
 
-  const size_t num_classes = CLI::GetParam<size_t>("num_classes");
-  /*
-  Should number of classes be input or should it be
-  derived from the labels row ?
-  */
   const string testingDataFilename = CLI::GetParam<std::string>("test_file");
+  if (testingDataFilename == "")
+    return;
+
   mat testingData;
   data::Load(testingDataFilename, testingData, true);
 
-  if (testingData.n_rows != trainingData.n_rows)
+  if (dimensionality != 0 && testingData.n_rows != dimensionality)
     Log::Fatal << "Test data dimensionality (" << testingData.n_rows << ") "
-        << "must be the same as training data (" << trainingData.n_rows - 1
+        << "must be the same as training data (" << dimensionality
         << ")!" << std::endl;
-
-  Timer::Start("training");
-  DecisionStump<> ds(trainingData, labels, num_classes, inpBucketSize);
-  Timer::Stop("training");
+  if (ds.SplitAttribute() >= (int) testingData.n_rows)
+    Log::Fatal << "Test data dimensionality (" << testingData.n_rows << ") "
+        << "is too small for the splitting attribute of the stump ("
+        << ds.SplitAttribute() << ")!" << std::endl;
 
   Row<size_t> predictedLabels(testingData.n_cols);
   Timer::Start("testing");
@@ -85,6 +167,102 @@ int main(int argc, char *argv[])
   const string outputFilename = CLI::GetParam<string>("output");
   data::Save(outputFilename, results, true, true);
   // saving the predictedLabels in the transposed manner in output
+}
+
+int main(int argc, char *argv[])
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("threads") < 0)
+    Log::Fatal << "--threads must not be negative!" << std::endl;
+  const size_t threads = CLI::GetParam<int>("threads");
+
+  if (CLI::GetParam<string>("test_file") == "" &&
+      CLI::GetParam<string>("output_model") == "")
+    Log::Fatal << "Neither --test_file nor --output_model are specified; "
+        << "there is nothing to do!" << std::endl;
+
+  const string inputModelFilename = CLI::GetParam<string>("input_model");
+  if (inputModelFilename != "")
+  {
+    if (CLI::GetParam<string>("train_file") != "")
+      Log::Fatal << "Only one of --input_model and --train_file may be given!"
+          << std::endl;
+
+    // The stump uses the mapped file in place, so the model must stay alive
+    // while the stump is in use.
+    MappedStumpModel model(inputModelFilename);
+    DecisionStump<> ds(model, threads);
+    const vec mappings(model.LabelValues(), model.Header().numLabelValues,
+        false, true);
+
+    SaveAndClassify(ds, mappings, 0);
+    return 0;
+  }
+
+  const string trainingDataFilename = CLI::GetParam<string>("train_file");
+  const string labelsFilename = CLI::GetParam<string>("labels_file");
+  if (trainingDataFilename == "" || labelsFilename == "")
+    Log::Fatal << "--train_file and --labels_file must be given unless "
+        << "--input_model is!" << std::endl;
+
+  size_t inpBucketSize = CLI::GetParam<int>("bucket_size");
+  if (CLI::GetParam<int>("num_classes") <= 0)
+    Log::Fatal << "--num_classes must be positive!" << std::endl;
+  const size_t num_classes = CLI::GetParam<int>("num_classes");
+  /*
+  Should number of classes be input or should it be
+  derived from the labels row ?
+  */
+
+  const size_t histogramBins = CLI::GetParam<int>("histogram_bins");
+  if (histogramBins > 256)
+    Log::Fatal << "--histogram_bins must be at most 256 (was " << histogramBins
+        << ")!" << std::endl;
+
+  if (CLI::GetParam<int>("chunk_size") < 0)
+    Log::Fatal << "--chunk_size must not be negative!" << std::endl;
+  const bool streaming = (CLI::GetParam<int>("chunk_size") > 0);
+
+  // helpers for normalizing the labels
+  Col<size_t> labels;
+  vec mappings;
+
+  mat trainingData;
+  size_t dimensionality;
+  if (streaming)
+  {
+    dimensionality = ChunkedReader(trainingDataFilename, 1).Dimensionality();
+  }
+  else
+  {
+    data::Load(trainingDataFilename, trainingData, true);
+    dimensionality = trainingData.n_rows;
+
+    // Load labels.
+    mat labelsIn;
+    data::Load(labelsFilename, labelsIn, true);
+
+    // Do the labels need to be transposed?
+    if (labelsIn.n_rows == 1)
+      labelsIn = labelsIn.t();
+
+    // normalize the labels
+    data::NormalizeLabels(labelsIn.unsafe_col(0), labels, mappings);
+  }
+
+  Timer::Start("training");
+  DecisionStump<> ds = streaming ?
+      TrainStreaming(trainingDataFilename, labelsFilename, num_classes,
+          inpBucketSize, histogramBins, threads, mappings) :
+      (histogramBins == 0) ?
+      DecisionStump<>(trainingData, labels, num_classes, inpBucketSize,
+          threads) :
+      DecisionStump<>(QuantizedDataset<>(trainingData, histogramBins), labels,
+          num_classes, inpBucketSize, threads);
+  Timer::Stop("training");
+
+  SaveAndClassify(ds, mappings, dimensionality);
 
   return 0;
 }
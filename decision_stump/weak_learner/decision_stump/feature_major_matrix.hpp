@@ -0,0 +1,89 @@
+/**
+ * @file feature_major_matrix.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the FeatureMajorMatrix class, a dense dataset stored one
+ * attribute per column so that each attribute is contiguous in memory.
+ */
+#ifndef __MLPACK_METHODS_DECISION_STUMP_FEATURE_MAJOR_MATRIX_HPP
+#define __MLPACK_METHODS_DECISION_STUMP_FEATURE_MAJOR_MATRIX_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace decision_stump {
+
+/**
+ * This class holds a dense dataset in feature-major order: internally, each
+ * attribute is stored as a contiguous column, instead of each point as with
+ * arma::mat.  It presents the same view of the data as an arma::mat would
+ * (n_rows is the number of attributes, n_cols the number of points), so it can
+ * be used as the MatType of DecisionStump, PresortedIndex and
+ * QuantizedDataset:
+ *
+ * @code
+ * FeatureMajorMatrix data(trainingData);
+ * DecisionStump<FeatureMajorMatrix> ds(data, labels, classes, bucketSize);
+ * @endcode
+ *
+ * Reading an attribute with row() does not copy it; the returned vector uses
+ * the memory of this object, so it must not outlive it.
+ *
+ * A dataset loaded with data::Load() and transpose = false is already in
+ * feature-major order, and can be passed with pointsAsRows = true to avoid
+ * transposing it.
+ */
+class FeatureMajorMatrix
+{
+ public:
+  /**
+   * Create the feature-major matrix from the given dataset.
+   *
+   * @param data Dataset to store.
+   * @param pointsAsRows If false (the default), data holds one point per
+   *     column, as usual, and is transposed; if true, data already holds one
+   *     point per row and is stored as-is.
+   */
+  FeatureMajorMatrix(const arma::mat& data, const bool pointsAsRows = false) :
+      n_rows(pointsAsRows ? data.n_cols : data.n_rows),
+      n_cols(pointsAsRows ? data.n_rows : data.n_cols)
+  {
+    if (pointsAsRows)
+      features = data;
+    else
+      features = arma::trans(data);
+  }
+
+  //! The number of attributes (as with arma::mat).
+  const size_t n_rows;
+  //! The number of points (as with arma::mat).
+  const size_t n_cols;
+
+  /**
+   * Get the values of the given attribute for every point, without copying
+   * them.
+   *
+   * @param attribute Attribute to get.
+   */
+  const arma::rowvec row(const size_t attribute) const
+  {
+    return arma::rowvec(const_cast<double*>(features.colptr(attribute)), n_cols,
+        false, true);
+  }
+
+  //! Get the value of the given attribute of the given point.
+  double operator()(const size_t attribute, const size_t point) const
+  { return features(point, attribute); }
+
+  //! Get the underlying matrix, holding one attribute per column.
+  const arma::mat& Features() const { return features; }
+
+ private:
+  //! The dataset, stored one attribute per column.
+  arma::mat features;
+};
+
+}; // namespace decision_stump
+}; // namespace mlpack
+
+#endif
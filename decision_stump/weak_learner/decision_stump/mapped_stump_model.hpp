@@ -0,0 +1,224 @@
+/**
+ * @file mapped_stump_model.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the binary model format for decision stumps, and of the
+ * MappedStumpModel class, which memory-maps a model file so that a stump can
+ * be loaded without reading or copying it.
+ */
+#ifndef __MLPACK_METHODS_DECISION_STUMP_MAPPED_STUMP_MODEL_HPP
+#define __MLPACK_METHODS_DECISION_STUMP_MAPPED_STUMP_MODEL_HPP
+
+#include <mlpack/core.hpp>
+
+#include <stdint.h>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace decision_stump {
+
+/**
+ * The header of a decision stump model file.  A model file holds, in this
+ * order and in native byte order:
+ *
+ *  - this header (48 bytes);
+ *  - the split values (numBins doubles);
+ *  - the original values of the labels (numLabelValues doubles), so that the
+ *    predicted classes can be mapped back to them;
+ *  - the label of each bin (numBins 64-bit unsigned integers).
+ *
+ * Every section starts at a multiple of 8 bytes, so that the file can be used
+ * in place once it is mapped into memory.
+ */
+struct StumpModelHeader
+{
+  //! Identifies the file as a stump model: "MLDS".
+  char magic[4];
+  //! The version of the format; files of any other version are rejected.
+  uint32_t version;
+  //! The number of classes.
+  uint64_t numClass;
+  //! The splitting attribute.
+  int64_t splitAttribute;
+  //! The bucket size the stump was trained with.
+  uint64_t bucketSize;
+  //! The number of bins (split values and bin labels).
+  uint64_t numBins;
+  //! The number of original label values.
+  uint64_t numLabelValues;
+
+  //! The current version of the format.
+  static const uint32_t CurrentVersion = 1;
+};
+
+/**
+ * This class maps a decision stump model file, written by DecisionStump::Save(),
+ * into memory.  Loading costs a single mmap() call plus a check of the header;
+ * the split values and bin labels are only read from disk when they are first
+ * used, and pages of the same file mapped by several processes are shared.  A
+ * DecisionStump constructed from a MappedStumpModel uses the mapped memory
+ * directly, so it must not outlive the MappedStumpModel.
+ *
+ * @code
+ * MappedStumpModel model("stump.bin");
+ * DecisionStump<> ds(model);
+ * ds.Classify(testData, predictedLabels);
+ * @endcode
+ *
+ * The file is mapped copy-on-write, so modifying the loaded stump never
+ * modifies the file.  On Windows, the file is read into memory instead.
+ */
+class MappedStumpModel
+{
+ public:
+  /**
+   * Map the given model file into memory, and check its header.
+   *
+   * @param filename Model file to map.
+   */
+  MappedStumpModel(const std::string& filename) :
+      data(NULL),
+      size(0)
+  {
+#ifdef _WIN32
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream.is_open())
+      Log::Fatal << "MappedStumpModel: cannot open '" << filename << "'!"
+          << std::endl;
+
+    // Read into 64-bit words so that the sections stay aligned.
+    stream.seekg(0, std::ios::end);
+    const std::streamoff length = stream.tellg();
+    stream.seekg(0, std::ios::beg);
+    if (length < (std::streamoff) sizeof(StumpModelHeader))
+      Log::Fatal << "MappedStumpModel: '" << filename << "' is too small to be "
+          << "a stump model!" << std::endl;
+    size = length;
+
+    buffer.resize((size + 7) / 8);
+    stream.read((char*) &buffer[0], size);
+    data = (char*) &buffer[0];
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      Log::Fatal << "MappedStumpModel: cannot open '" << filename << "'!"
+          << std::endl;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+      close(fd);
+      Log::Fatal << "MappedStumpModel: cannot stat '" << filename << "'!"
+          << std::endl;
+    }
+    size = info.st_size;
+
+    if (size >= sizeof(StumpModelHeader))
+    {
+      void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+          0);
+      if (mapping != MAP_FAILED)
+        data = (char*) mapping;
+    }
+
+    // The mapping stays valid once the file is closed.
+    close(fd);
+#endif
+
+    if (size < sizeof(StumpModelHeader))
+      Log::Fatal << "MappedStumpModel: '" << filename << "' is too small to be "
+          << "a stump model!" << std::endl;
+    if (data == NULL)
+      Log::Fatal << "MappedStumpModel: cannot map '" << filename << "'!"
+          << std::endl;
+
+    const StumpModelHeader& header = Header();
+    if (std::memcmp(header.magic, "MLDS", 4) != 0)
+      Log::Fatal << "MappedStumpModel: '" << filename << "' is not a stump "
+          << "model!" << std::endl;
+    if (header.version != StumpModelHeader::CurrentVersion)
+      Log::Fatal << "MappedStumpModel: '" << filename << "' has version "
+          << header.version << ", but only version "
+          << StumpModelHeader::CurrentVersion << " is supported!" << std::endl;
+
+    // Bound the counts by the size of the file before computing the size they
+    // imply, so that a corrupt header can't make that computation wrap around.
+    const uint64_t bodySize = size - sizeof(StumpModelHeader);
+    if (header.numBins == 0 || header.numLabelValues == 0 ||
+        header.splitAttribute < 0 ||
+        header.numBins > bodySize / (sizeof(double) + sizeof(uint64_t)) ||
+        header.numLabelValues > bodySize / sizeof(double) ||
+        (uint64_t) size != ExpectedSize(header))
+      Log::Fatal << "MappedStumpModel: '" << filename << "' is corrupt!"
+          << std::endl;
+  }
+
+  //! Unmap the file.
+  ~MappedStumpModel()
+  {
+#ifndef _WIN32
+    if (data != NULL)
+      munmap(data, size);
+#endif
+  }
+
+  //! Get the header of the model.
+  const StumpModelHeader& Header() const
+  { return *(const StumpModelHeader*) data; }
+
+  //! Get the split values of the model (Header().numBins of them).
+  double* Split() const
+  { return (double*) (data + sizeof(StumpModelHeader)); }
+
+  //! Get the original label values (Header().numLabelValues of them).
+  double* LabelValues() const
+  { return Split() + Header().numBins; }
+
+  //! Get the label of each bin (Header().numBins of them).
+  uint64_t* BinLabels() const
+  { return (uint64_t*) (LabelValues() + Header().numLabelValues); }
+
+  /**
+   * Get the size of a model file with the given header.  The counts of the
+   * header must be bounded first (as the constructor does), or the result may
+   * wrap around.
+   *
+   * @param header Header of the model file.
+   */
+  static uint64_t ExpectedSize(const StumpModelHeader& header)
+  {
+    return sizeof(StumpModelHeader) + sizeof(double) * (header.numBins +
+        header.numLabelValues) + sizeof(uint64_t) * header.numBins;
+  }
+
+ private:
+  // A mapping can't be copied.
+  MappedStumpModel(const MappedStumpModel&);
+  MappedStumpModel& operator=(const MappedStumpModel&);
+
+  //! The mapped contents of the file.
+  char* data;
+
+  //! The size of the file.
+  size_t size;
+
+#ifdef _WIN32
+  //! The contents of the file, when it can't be mapped.
+  std::vector<uint64_t> buffer;
+#endif
+};
+
+}; // namespace decision_stump
+}; // namespace mlpack
+
+#endif
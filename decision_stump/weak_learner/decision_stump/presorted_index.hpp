@@ -0,0 +1,220 @@
+/**
+ * @file presorted_index.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the PresortedIndex class, which caches the sort order of every
+ * attribute of a dataset so that many decision stumps can be trained on the
+ * same data without sorting it again.
+ */
+#ifndef __MLPACK_METHODS_DECISION_STUMP_PRESORTED_INDEX_HPP
+#define __MLPACK_METHODS_DECISION_STUMP_PRESORTED_INDEX_HPP
+
+#include <mlpack/core.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace mlpack {
+namespace decision_stump {
+
+/**
+ * This class holds, for each attribute (row) of a dataset, the indices of the
+ * points in that attribute in (stably) sorted order, along with a mask of which
+ * attributes are constant and so can never be split on.  Building the index
+ * costs O(d n log n); after that, any number of DecisionStump objects may be
+ * trained on the same dataset (with any labels, weights or bucket size) without
+ * sorting again.
+ *
+ * The index only depends on the data, so it must not be reused after the data
+ * has been modified.
+ *
+ * @tparam MatType Type of matrix that is being used (sparse or dense).
+ */
+template<typename MatType = arma::mat>
+class PresortedIndex
+{
+ public:
+  /**
+   * Build the index by sorting each attribute of the given dataset.
+   *
+   * @param data Dataset to be indexed (one point per column).
+   */
+  PresortedIndex(const MatType& data) :
+      order(data.n_cols, data.n_rows),
+      distinct(data.n_rows, false)
+  {
+    for (size_t i = 0; i < data.n_rows; ++i)
+    {
+      const arma::rowvec attribute = data.row(i);
+
+      order.col(i) = arma::stable_sort_index(attribute.t());
+
+      // An attribute is constant if its smallest and largest values are equal.
+      if (attribute.n_elem > 0)
+        distinct[i] = (attribute(order(0, i)) !=
+            attribute(order(attribute.n_elem - 1, i)));
+    }
+  }
+
+  //! Get the number of points in the indexed dataset.
+  size_t NumPoints() const { return order.n_rows; }
+  //! Get the number of attributes in the indexed dataset.
+  size_t Dimensionality() const { return order.n_cols; }
+
+  /**
+   * Get the sorted order of every attribute.  Column i holds the indices of the
+   * points of attribute i, in increasing order of value.
+   */
+  const arma::Mat<arma::uword>& Order() const { return order; }
+
+  /**
+   * Returns true if not all of the values of the given attribute are the same.
+   *
+   * @param attribute The attribute which is checked for identical values.
+   */
+  bool IsDistinct(const size_t attribute) const { return distinct[attribute]; }
+
+ private:
+  //! The sorted order of each attribute, stored one attribute per column.
+  arma::Mat<arma::uword> order;
+
+  //! Whether or not each attribute takes more than one value.
+  std::vector<bool> distinct;
+};
+
+/**
+ * The presorted index of a sparse dataset.  Only the nonzero values of each
+ * attribute are sorted; the implicit zeros of an attribute all have the same
+ * value, so they are not stored at all, and a decision stump handles them as
+ * a single block placed between the negative and the positive values.  The
+ * index takes O(nnz) memory, and building it costs O(nnz log nnz).
+ */
+template<>
+class PresortedIndex<arma::sp_mat>
+{
+ public:
+  /**
+   * Build the index by sorting the nonzero values of each attribute of the
+   * given sparse dataset.
+   *
+   * @param data Dataset to be indexed (one point per column).
+   */
+  PresortedIndex(const arma::sp_mat& data) :
+      numPoints(data.n_cols),
+      offsets(data.n_rows + 1),
+      numNegative(data.n_rows),
+      distinct(data.n_rows, false)
+  {
+    // Count the nonzeros of each attribute, to find where each attribute's
+    // nonzeros start.
+    offsets.zeros();
+    arma::sp_mat::const_iterator it;
+    for (it = data.begin(); it != data.end(); ++it)
+      offsets[it.row() + 1]++;
+    for (size_t i = 0; i < data.n_rows; ++i)
+      offsets[i + 1] += offsets[i];
+
+    // Group the nonzeros by attribute.  They are visited in order of point, so
+    // each group is in order of point too.
+    points.set_size(offsets[data.n_rows]);
+    values.set_size(offsets[data.n_rows]);
+    arma::Col<arma::uword> next = offsets;
+    for (it = data.begin(); it != data.end(); ++it)
+    {
+      const size_t position = next[it.row()]++;
+      points[position] = it.col();
+      values[position] = (*it);
+    }
+
+    for (size_t i = 0; i < data.n_rows; ++i)
+    {
+      const size_t begin = offsets[i];
+      const size_t count = offsets[i + 1] - offsets[i];
+
+      double minValue = 0.0, maxValue = 0.0;
+      numNegative[i] = 0;
+      if (count > 0)
+      {
+        // Sort the nonzeros of this attribute (stably, so ties stay in order of
+        // point).
+        const arma::vec attValues = values.subvec(begin, begin + count - 1);
+        const arma::Col<arma::uword> attPoints = points.subvec(begin,
+            begin + count - 1);
+        const arma::uvec order = arma::stable_sort_index(attValues);
+        for (size_t k = 0; k < count; ++k)
+        {
+          values[begin + k] = attValues[order[k]];
+          points[begin + k] = attPoints[order[k]];
+          if (values[begin + k] < 0)
+            numNegative[i]++;
+        }
+
+        minValue = values[begin];
+        maxValue = values[begin + count - 1];
+      }
+
+      // The implicit zeros take part in the range of values too.
+      if (count < numPoints)
+      {
+        minValue = std::min(minValue, 0.0);
+        maxValue = std::max(maxValue, 0.0);
+      }
+      distinct[i] = (minValue != maxValue);
+    }
+  }
+
+  //! Get the number of points in the indexed dataset.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the number of attributes in the indexed dataset.
+  size_t Dimensionality() const { return offsets.n_elem - 1; }
+
+  /**
+   * Get the offset of the nonzeros of each attribute in Points() and Values();
+   * the nonzeros of attribute i are at [Offsets()[i], Offsets()[i + 1]).
+   */
+  const arma::Col<arma::uword>& Offsets() const { return offsets; }
+  //! Get the point of each nonzero, grouped by attribute and sorted by value.
+  const arma::Col<arma::uword>& Points() const { return points; }
+  //! Get the value of each nonzero, grouped by attribute and sorted by value.
+  const arma::vec& Values() const { return values; }
+
+  //! Get the number of nonzero values of the given attribute.
+  size_t NumNonzeros(const size_t attribute) const
+  { return offsets[attribute + 1] - offsets[attribute]; }
+
+  //! Get the number of negative values of the given attribute.
+  size_t NumNegative(const size_t attribute) const
+  { return numNegative[attribute]; }
+
+  /**
+   * Returns true if not all of the values (including the implicit zeros) of
+   * the given attribute are the same.
+   *
+   * @param attribute The attribute which is checked for identical values.
+   */
+  bool IsDistinct(const size_t attribute) const { return distinct[attribute]; }
+
+ private:
+  //! The number of points in the indexed dataset.
+  size_t numPoints;
+
+  //! The offset of the nonzeros of each attribute.
+  arma::Col<arma::uword> offsets;
+
+  //! The point of each nonzero, grouped by attribute and sorted by value.
+  arma::Col<arma::uword> points;
+
+  //! The value of each nonzero, grouped by attribute and sorted by value.
+  arma::vec values;
+
+  //! The number of negative values of each attribute.
+  arma::Col<arma::uword> numNegative;
+
+  //! Whether or not each attribute takes more than one value.
+  std::vector<bool> distinct;
+};
+
+}; // namespace decision_stump
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file quantized_dataset.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the QuantizedDataset class, which buckets every attribute of a
+ * dataset into at most 256 bins so that decision stumps can be trained with
+ * class-count histograms instead of sorting.
+ */
+#ifndef __MLPACK_METHODS_DECISION_STUMP_QUANTIZED_DATASET_HPP
+#define __MLPACK_METHODS_DECISION_STUMP_QUANTIZED_DATASET_HPP
+
+#include <mlpack/core.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace mlpack {
+namespace decision_stump {
+
+/**
+ * Find the lower edges of at most maxBins bins for the given values of an
+ * attribute.  If there are no more than maxBins distinct values, every value
+ * gets its own bin; otherwise the edges are taken at evenly spaced quantiles of
+ * the values, dropping repeats.  Every edge is one of the given values.
+ *
+ * @param attribute Values of the attribute (need not be sorted).
+ * @param maxBins Maximum number of bins.
+ */
+inline arma::vec QuantileBinEdges(const arma::rowvec& attribute,
+                                  const size_t maxBins)
+{
+  const arma::vec values = arma::unique(attribute.t());
+  if (values.n_elem <= maxBins)
+    return values;
+
+  const arma::rowvec sorted = arma::sort(attribute);
+  arma::vec binEdges(maxBins);
+  size_t numBins = 0;
+  for (size_t b = 0; b < maxBins; ++b)
+  {
+    const double edge = sorted((b * sorted.n_elem) / maxBins);
+    if ((numBins == 0) || (edge != binEdges(numBins - 1)))
+      binEdges(numBins++) = edge;
+  }
+
+  return binEdges.subvec(0, numBins - 1);
+}
+
+/**
+ * This class holds a quantized copy of a dataset.  Every attribute is split
+ * into at most maxBins bins (at most 256), and each point is then stored as
+ * the one-byte index of the bin it falls into.  If an attribute takes no more
+ * than maxBins distinct values, every value gets its own bin; otherwise the bin
+ * boundaries are taken at evenly spaced quantiles of the attribute.
+ *
+ * Bin b of attribute i holds the points whose value lies in the range
+ * [BinEdges(i)[b], BinEdges(i)[b + 1]), and its lower edge is always a value
+ * which actually occurs in the data, so that a stump trained on the quantized
+ * data splits on real attribute values.
+ *
+ * Once built, the original dataset is no longer needed for training; the
+ * quantized data takes one eighth of the memory of an arma::mat.
+ *
+ * @tparam MatType Type of matrix that is being used (sparse or dense).
+ */
+template<typename MatType = arma::mat>
+class QuantizedDataset
+{
+ public:
+  /**
+   * Quantize the given dataset.
+   *
+   * @param data Dataset to be quantized (one point per column).
+   * @param maxBins Maximum number of bins per attribute (at most 256).
+   */
+  QuantizedDataset(const MatType& data, const size_t maxBins = 256) :
+      codes(data.n_cols, data.n_rows),
+      edges(data.n_rows)
+  {
+    if ((maxBins == 0) || (maxBins > 256))
+      Log::Fatal << "QuantizedDataset: maxBins must be between 1 and 256 (was "
+          << maxBins << ")!" << std::endl;
+
+    for (size_t i = 0; i < data.n_rows; ++i)
+    {
+      const arma::rowvec attribute = data.row(i);
+      edges[i] = QuantileBinEdges(attribute, maxBins);
+
+      for (size_t j = 0; j < attribute.n_elem; ++j)
+        codes(j, i) = (unsigned char) Bin(i, attribute(j));
+    }
+  }
+
+  //! Get the number of points in the quantized dataset.
+  size_t NumPoints() const { return codes.n_rows; }
+  //! Get the number of attributes in the quantized dataset.
+  size_t Dimensionality() const { return codes.n_cols; }
+
+  /**
+   * Get the bin indices of every point.  Column i holds the bin of each point
+   * for attribute i.
+   */
+  const arma::Mat<unsigned char>& Codes() const { return codes; }
+
+  /**
+   * Get the lower edge of every bin of the given attribute, in increasing
+   * order.
+   */
+  const arma::vec& BinEdges(const size_t attribute) const
+  { return edges[attribute]; }
+
+  //! Get the number of bins of the given attribute.
+  size_t NumBins(const size_t attribute) const
+  { return edges[attribute].n_elem; }
+
+  /**
+   * Returns true if not all of the values of the given attribute are the same.
+   *
+   * @param attribute The attribute which is checked for identical values.
+   */
+  bool IsDistinct(const size_t attribute) const
+  { return edges[attribute].n_elem > 1; }
+
+  /**
+   * Find the bin that a value of the given attribute falls into.  Values below
+   * the first edge are put into the first bin.
+   *
+   * @param attribute Attribute the value belongs to.
+   * @param value Value to find the bin of.
+   */
+  size_t Bin(const size_t attribute, const double value) const
+  {
+    const arma::vec& binEdges = edges[attribute];
+    const size_t upper = std::upper_bound(binEdges.begin(), binEdges.end(),
+        value) - binEdges.begin();
+    return (upper == 0) ? 0 : upper - 1;
+  }
+
+ private:
+  //! The bin of each point, stored one attribute per column.
+  arma::Mat<unsigned char> codes;
+
+  //! The lower edges of the bins of each attribute.
+  std::vector<arma::vec> edges;
+};
+
+}; // namespace decision_stump
+}; // namespace mlpack
+
+#endif
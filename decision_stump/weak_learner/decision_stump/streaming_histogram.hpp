@@ -0,0 +1,265 @@
+/**
+ * @file streaming_histogram.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the StreamingHistogram class, which builds the class-count
+ * histograms needed to train a decision stump from a dataset that is read in
+ * chunks, without ever holding the whole dataset in memory.
+ */
+#ifndef __MLPACK_METHODS_DECISION_STUMP_STREAMING_HISTOGRAM_HPP
+#define __MLPACK_METHODS_DECISION_STUMP_STREAMING_HISTOGRAM_HPP
+
+#include <mlpack/core.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "quantized_dataset.hpp"
+
+namespace mlpack {
+namespace decision_stump {
+
+/**
+ * This class builds, in two passes over a dataset which is read in chunks, the
+ * per-attribute class-count histograms from which a DecisionStump can be
+ * trained:
+ *
+ * @code
+ * StreamingHistogram histogram(dimensionality, classes);
+ * while (ReadChunk(chunk))                 // First pass.
+ *   histogram.Sketch(chunk);
+ * histogram.ComputeBinEdges();
+ * while (ReadChunk(chunk, labels))         // Second pass.
+ *   histogram.Count(chunk, labels);
+ * DecisionStump<> ds(histogram, bucketSize);
+ * @endcode
+ *
+ * The first pass keeps a uniform sample (a reservoir) of at most sketchSize
+ * points, from which the bin edges of each attribute are taken at quantiles,
+ * as QuantizedDataset does.  The second pass counts the points of each class
+ * falling into each bin.  Memory use is therefore bounded by the sketch size
+ * and the number of bins, and does not depend on the number of points; if the
+ * dataset has no more than sketchSize points, the bins are exactly those of a
+ * QuantizedDataset built from it.
+ */
+class StreamingHistogram
+{
+ public:
+  /**
+   * Create an empty histogram.
+   *
+   * @param dimensionality Number of attributes of the data.
+   * @param classes Number of distinct classes in the labels.
+   * @param bins Maximum number of bins per attribute.
+   * @param sketchSize Maximum number of points kept to find the bin edges.
+   */
+  StreamingHistogram(const size_t dimensionality,
+                     const size_t classes,
+                     const size_t bins = 256,
+                     const size_t sketchSize = 65536) :
+      numClasses(classes),
+      maxBins(bins),
+      sketchSize(sketchSize),
+      sketch(dimensionality, 0),
+      numSketched(0),
+      numPoints(0),
+      edges(dimensionality),
+      binCounts(dimensionality),
+      binSizes(dimensionality),
+      classCounts(classes)
+  {
+    if (bins == 0)
+      Log::Fatal << "StreamingHistogram: number of bins must be positive!"
+          << std::endl;
+    if (sketchSize == 0)
+      Log::Fatal << "StreamingHistogram: sketchSize must be positive!"
+          << std::endl;
+
+    classCounts.zeros();
+  }
+
+  /**
+   * Add a chunk of points to the sketch (first pass).  Once the sketch is full,
+   * each new point replaces a random one of the sketch with the probability
+   * that keeps the sketch a uniform sample of every point seen.
+   *
+   * @param chunk Chunk of points (one point per column).
+   */
+  void Sketch(const arma::mat& chunk)
+  {
+    CheckDimensionality(chunk);
+
+    // Until the sketch is full, it grows as points arrive, so that a small
+    // dataset does not pay for a large sketch.
+    const size_t needed = std::min(numSketched + chunk.n_cols, sketchSize);
+    if (needed > sketch.n_cols)
+      sketch.resize(sketch.n_rows, std::min(std::max(needed,
+          (size_t) (2 * sketch.n_cols)), sketchSize));
+
+    for (size_t j = 0; j < chunk.n_cols; ++j)
+    {
+      size_t slot = numSketched;
+      if (numSketched >= sketchSize)
+        slot = (size_t) (math::Random() * (numSketched + 1));
+      if (slot < sketchSize)
+        sketch.col(slot) = chunk.col(j);
+
+      numSketched++;
+    }
+  }
+
+  /**
+   * Compute the bin edges of each attribute from the sketch, release the
+   * sketch, and get ready to count points.  This must be called between the
+   * two passes.
+   */
+  void ComputeBinEdges()
+  {
+    const size_t sampled = std::min(numSketched, sketchSize);
+    if (sampled == 0)
+      Log::Fatal << "StreamingHistogram: no points were sketched!" << std::endl;
+
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+      const arma::rowvec attribute = sketch.submat(i, 0, i, sampled - 1);
+      edges[i] = QuantileBinEdges(attribute, maxBins);
+
+      binCounts[i].zeros(numClasses, edges[i].n_elem);
+      binSizes[i].zeros(edges[i].n_elem);
+    }
+
+    sketch.reset();
+  }
+
+  /**
+   * Count a chunk of labeled points into the histograms (second pass).
+   *
+   * @param chunk Chunk of points (one point per column).
+   * @param labels Labels of the points of the chunk.
+   */
+  void Count(const arma::mat& chunk, const arma::Row<size_t>& labels)
+  {
+    CheckDimensionality(chunk);
+    if (labels.n_elem != chunk.n_cols)
+      Log::Fatal << "StreamingHistogram: number of labels (" << labels.n_elem
+          << ") does not match number of points (" << chunk.n_cols << ")!"
+          << std::endl;
+
+    for (size_t j = 0; j < chunk.n_cols; ++j)
+    {
+      const size_t label = labels[j];
+      if (label >= numClasses)
+        Log::Fatal << "StreamingHistogram: label " << label << " is not less "
+            << "than the number of classes (" << numClasses << ")!"
+            << std::endl;
+
+      const double* point = chunk.colptr(j);
+      for (size_t i = 0; i < edges.size(); ++i)
+      {
+        const size_t bin = Bin(i, point[i]);
+        binCounts[i](label, bin)++;
+        binSizes[i][bin]++;
+      }
+
+      classCounts[label]++;
+    }
+
+    numPoints += chunk.n_cols;
+  }
+
+  //! Get the number of attributes.
+  size_t Dimensionality() const { return edges.size(); }
+  //! Get the number of classes.
+  size_t NumClasses() const { return numClasses; }
+  //! Get the number of points counted so far.
+  size_t NumPoints() const { return numPoints; }
+
+  //! Get the lower edge of every bin of the given attribute.
+  const arma::vec& BinEdges(const size_t attribute) const
+  { return edges[attribute]; }
+  //! Get the number of bins of the given attribute.
+  size_t NumBins(const size_t attribute) const
+  { return edges[attribute].n_elem; }
+
+  /**
+   * Get the count of each class (row) in each bin (column) of the given
+   * attribute.
+   */
+  const arma::mat& BinCounts(const size_t attribute) const
+  { return binCounts[attribute]; }
+  //! Get the number of points in each bin of the given attribute.
+  const arma::vec& BinSizes(const size_t attribute) const
+  { return binSizes[attribute]; }
+
+  //! Get the total count of each class.
+  const arma::vec& ClassCounts() const { return classCounts; }
+
+  /**
+   * Returns true if the given attribute has more than one bin, and so can be
+   * split on.
+   *
+   * @param attribute The attribute which is checked for identical values.
+   */
+  bool IsDistinct(const size_t attribute) const
+  { return edges[attribute].n_elem > 1; }
+
+  /**
+   * Find the bin that a value of the given attribute falls into.  Values below
+   * the first edge are put into the first bin.
+   *
+   * @param attribute Attribute the value belongs to.
+   * @param value Value to find the bin of.
+   */
+  size_t Bin(const size_t attribute, const double value) const
+  {
+    const arma::vec& binEdges = edges[attribute];
+    const size_t upper = std::upper_bound(binEdges.begin(), binEdges.end(),
+        value) - binEdges.begin();
+    return (upper == 0) ? 0 : upper - 1;
+  }
+
+ private:
+  //! Make sure that a chunk has the right number of attributes.
+  void CheckDimensionality(const arma::mat& chunk) const
+  {
+    if (chunk.n_rows != edges.size())
+      Log::Fatal << "StreamingHistogram: chunk dimensionality ("
+          << chunk.n_rows << ") does not match histogram dimensionality ("
+          << edges.size() << ")!" << std::endl;
+  }
+
+  //! The number of classes.
+  size_t numClasses;
+
+  //! The maximum number of bins per attribute.
+  size_t maxBins;
+
+  //! The maximum number of points in the sketch.
+  size_t sketchSize;
+
+  //! The uniform sample of points used to find the bin edges.
+  arma::mat sketch;
+
+  //! The number of points seen during the first pass.
+  size_t numSketched;
+
+  //! The number of points counted during the second pass.
+  size_t numPoints;
+
+  //! The lower edges of the bins of each attribute.
+  std::vector<arma::vec> edges;
+
+  //! The count of each class in each bin, for each attribute.
+  std::vector<arma::mat> binCounts;
+
+  //! The number of points in each bin, for each attribute.
+  std::vector<arma::vec> binSizes;
+
+  //! The total count of each class.
+  arma::vec classCounts;
+};
+
+}; // namespace decision_stump
+}; // namespace mlpack
+
+#endif
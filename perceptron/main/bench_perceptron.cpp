@@ -0,0 +1,287 @@
+/*
+ * @author: Udit Saxena
+ * @file: bench_perceptron.cpp
+ *
+ * Benchmark for perceptron training and classification, and latency benchmark
+ * for single-point prediction.
+ */
+
+#include <mlpack/core.hpp>
+#include "perceptron.hpp"
+#include "../../bench/allocation_counter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <sys/time.h>
+#include <time.h>
+
+using namespace mlpack;
+using namespace mlpack::perceptron;
+using namespace std;
+using namespace arma;
+
+PROGRAM_INFO("Perceptron Benchmark", "This program benchmarks perceptron "
+    "training and classification on synthetic data, sweeping the number of "
+    "points, dimensions and classes.  For each setting it times single-threaded "
+    "and parallel training, and classification, and reports throughput and "
+    "allocation counts as JSON.  It also reports the median (p50) and 99th "
+    "percentile (p99) latency of classifying a single point with Predict().");
+
+PARAM_STRING("points", "Comma-separated list of numbers of training points.",
+    "n", "1000,10000,100000");
+PARAM_STRING("dimensions", "Comma-separated list of numbers of dimensions.",
+    "d", "10,100");
+PARAM_STRING("classes", "Comma-separated list of numbers of classes.", "c",
+    "2,10");
+PARAM_INT("iterations", "The maximum number of training iterations.", "i", 10);
+PARAM_INT("test_points", "The number of points to classify for each setting.",
+    "t", 100000);
+PARAM_INT("repetitions", "The number of times each setting is timed; the "
+    "fastest time is reported.", "r", 3);
+PARAM_INT("latency_points", "The number of single-point predictions timed for "
+    "the latency percentiles.", "p", 10000);
+PARAM_INT("threads", "The number of threads used by the parallel path.", "j",
+    4);
+PARAM_INT("seed", "Random seed for the synthetic data.", "s", 42);
+PARAM_STRING("output", "The file the JSON results are written to (standard "
+    "output if not given).", "o", "");
+
+//! Wall clock time, in seconds.
+double Now()
+{
+  timeval time;
+  gettimeofday(&time, NULL);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+//! Monotonic clock time, in nanoseconds, for timing single calls.
+double NowNanoseconds()
+{
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+//! Get the given percentile (in [0, 1]) of sorted values.
+double Percentile(const vector<double>& sorted, const double p)
+{
+  if (sorted.empty())
+    return 0.0;
+
+  return sorted[std::min((size_t) (p * sorted.size()), sorted.size() - 1)];
+}
+
+//! Parse a comma-separated list of positive integers.
+vector<size_t> ParseList(const string& name)
+{
+  vector<size_t> values;
+  stringstream stream(CLI::GetParam<string>(name));
+  string item;
+  while (getline(stream, item, ','))
+  {
+    const long value = atol(item.c_str());
+    if (value <= 0)
+      Log::Fatal << "--" << name << " must be a list of positive integers!"
+          << endl;
+    values.push_back(value);
+  }
+
+  return values;
+}
+
+/**
+ * Generate a synthetic dataset.  The label of each point is the class whose
+ * (random) linear score is largest, with 10% of the labels replaced by random
+ * ones, so that the data is close to linearly separable but not quite.
+ */
+void Generate(const mat& model,
+              const size_t points,
+              mat& data,
+              Row<size_t>& labels)
+{
+  data.randu(model.n_rows, points);
+  data -= 0.5;
+  labels.set_size(points);
+
+  const mat scores = model.t() * data;
+  for (size_t i = 0; i < points; ++i)
+  {
+    uword best;
+    scores.col(i).max(best);
+    labels[i] = (math::Random() < 0.1) ? math::RandInt(model.n_cols) : best;
+  }
+}
+
+//! The measurements of one training path on one setting.
+struct Result
+{
+  double trainSeconds;
+  double classifySeconds;
+  size_t trainAllocations;
+  size_t classifyAllocations;
+  double predictP50Nanoseconds;
+  double predictP99Nanoseconds;
+  size_t predictAllocations;
+};
+
+/**
+ * Time the given number of single-point predictions, cycling through the test
+ * points, and store the latency percentiles and allocation count in the result.
+ */
+void TimePredict(const Perceptron<>& p,
+                 const mat& test,
+                 const size_t latencyPoints,
+                 Result& result)
+{
+  // The latencies are stored in memory allocated beforehand, so that only
+  // Predict() can allocate while the allocations are counted.
+  vector<double> latencies(latencyPoints);
+  size_t checksum = 0;
+  const size_t startAllocations = allocations;
+  for (size_t i = 0; i < latencyPoints; ++i)
+  {
+    const double* point = test.colptr(i % test.n_cols);
+    const double start = NowNanoseconds();
+    checksum += p.Predict(point);
+    latencies[i] = NowNanoseconds() - start;
+  }
+  result.predictAllocations = allocations - startAllocations;
+
+  // Use the predictions, so that they can't be optimized away.
+  if (checksum == (size_t) -1)
+    Log::Warn << "Unlikely checksum." << endl;
+
+  std::sort(latencies.begin(), latencies.end());
+  result.predictP50Nanoseconds = Percentile(latencies, 0.5);
+  result.predictP99Nanoseconds = Percentile(latencies, 0.99);
+}
+
+/**
+ * Time training with the given number of threads, and classification, keeping
+ * the fastest of the given number of repetitions.  Single-point predictions
+ * are timed with the perceptron of the last repetition.
+ */
+Result Run(const mat& data,
+           const Row<size_t>& labels,
+           const mat& test,
+           const size_t iterations,
+           const size_t threads,
+           const size_t repetitions,
+           const size_t latencyPoints)
+{
+  Result result;
+  result.trainSeconds = result.classifySeconds = 0.0;
+  result.trainAllocations = result.classifyAllocations = 0;
+
+  Row<size_t> predictedLabels(test.n_cols);
+  for (size_t r = 0; r < repetitions; ++r)
+  {
+    const size_t startAllocations = allocations;
+    const double start = Now();
+    const Perceptron<> p(data, labels, iterations, threads);
+    const double trained = Now();
+    const size_t trainedAllocations = allocations;
+
+    p.Classify(test, predictedLabels);
+    const double classified = Now();
+
+    if (r == 0 || trained - start < result.trainSeconds)
+      result.trainSeconds = trained - start;
+    if (r == 0 || classified - trained < result.classifySeconds)
+      result.classifySeconds = classified - trained;
+    result.trainAllocations = trainedAllocations - startAllocations;
+    result.classifyAllocations = allocations - trainedAllocations;
+
+    if (r == repetitions - 1)
+      TimePredict(p, test, latencyPoints, result);
+  }
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const vector<size_t> pointsList = ParseList("points");
+  const vector<size_t> dimensionsList = ParseList("dimensions");
+  const vector<size_t> classesList = ParseList("classes");
+
+  if (CLI::GetParam<int>("iterations") <= 0 ||
+      CLI::GetParam<int>("test_points") <= 0 ||
+      CLI::GetParam<int>("repetitions") <= 0 ||
+      CLI::GetParam<int>("threads") <= 0)
+    Log::Fatal << "--iterations, --test_points, --repetitions and --threads "
+        << "must be positive!" << endl;
+  const size_t iterations = CLI::GetParam<int>("iterations");
+  const size_t testPoints = CLI::GetParam<int>("test_points");
+  const size_t repetitions = CLI::GetParam<int>("repetitions");
+  if (CLI::GetParam<int>("latency_points") < 0)
+    Log::Fatal << "--latency_points must be nonnegative!" << endl;
+  const size_t latencyPoints = CLI::GetParam<int>("latency_points");
+  const size_t threads = CLI::GetParam<int>("threads");
+
+  math::RandomSeed(CLI::GetParam<int>("seed"));
+
+  ofstream file;
+  const string outputFilename = CLI::GetParam<string>("output");
+  if (outputFilename != "")
+  {
+    file.open(outputFilename.c_str());
+    if (!file.is_open())
+      Log::Fatal << "Cannot open '" << outputFilename << "'!" << endl;
+  }
+  ostream& out = (outputFilename != "") ? file : cout;
+
+  const char* paths[] = { "single", "parallel" };
+  const size_t pathThreads[] = { 1, threads };
+
+  out << "[" << endl;
+  bool first = true;
+  for (size_t a = 0; a < pointsList.size(); ++a)
+  for (size_t b = 0; b < dimensionsList.size(); ++b)
+  for (size_t c = 0; c < classesList.size(); ++c)
+  {
+    mat model, data, test;
+    Row<size_t> labels, testLabels;
+    model.randn(dimensionsList[b], classesList[c]);
+    Generate(model, pointsList[a], data, labels);
+    Generate(model, testPoints, test, testLabels);
+
+    for (size_t p = 0; p < 2; ++p)
+    {
+      const Result result = Run(data, labels, test, iterations, pathThreads[p],
+          repetitions, latencyPoints);
+
+      if (!first)
+        out << "," << endl;
+      first = false;
+
+      out << "  { \"path\": \"" << paths[p] << "\""
+          << ", \"points\": " << pointsList[a]
+          << ", \"dimensions\": " << dimensionsList[b]
+          << ", \"classes\": " << classesList[c]
+          << ", \"threads\": " << pathThreads[p]
+          << ", \"train_seconds\": " << result.trainSeconds
+          << ", \"train_points_per_second\": "
+          << pointsList[a] / std::max(result.trainSeconds, 1e-9)
+          << ", \"train_allocations\": " << result.trainAllocations
+          << ", \"classify_seconds\": " << result.classifySeconds
+          << ", \"classify_points_per_second\": "
+          << testPoints / std::max(result.classifySeconds, 1e-9)
+          << ", \"classify_allocations\": " << result.classifyAllocations
+          << ", \"predict_p50_ns\": " << result.predictP50Nanoseconds
+          << ", \"predict_p99_ns\": " << result.predictP99Nanoseconds
+          << ", \"predict_allocations\": " << result.predictAllocations
+          << " }";
+      out.flush();
+    }
+  }
+  out << endl << "]" << endl;
+
+  return 0;
+}
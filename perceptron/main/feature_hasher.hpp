@@ -0,0 +1,198 @@
+/**
+ * @file feature_hasher.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the FeatureHasher class, which maps points made of arbitrary
+ * named features into a sparse matrix of fixed dimensionality (the hashing
+ * trick).
+ */
+#ifndef __MLPACK_METHODS_PERCEPTRON_FEATURE_HASHER_HPP
+#define __MLPACK_METHODS_PERCEPTRON_FEATURE_HASHER_HPP
+
+#include <mlpack/core.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * This class maps points whose features are identified by strings (such as
+ * the words of a document) into columns of a sparse matrix with 2^bits rows.
+ * Each feature is hashed with 64-bit FNV-1a; the low bits of the hash give the
+ * row of the feature, and the highest bit gives a sign, so that features which
+ * collide on the same row cancel out on average rather than add up.  The
+ * values of features which collide in the same point are summed.
+ *
+ * A perceptron trained on the hashed points has 2^bits weights per class, so
+ * its memory is bounded however many distinct features the data has, and no
+ * dictionary of the features needs to be kept.  Points are given as strings of
+ * whitespace-separated "feature:value" tokens; the value may be left out, and
+ * is then 1.
+ *
+ * @code
+ * FeatureHasher hasher(20);
+ * arma::sp_mat trainData, testData;
+ * hasher.Load("train.txt", trainData);
+ * hasher.Load("test.txt", testData);
+ *
+ * Perceptron<SimpleWeightUpdate, ZeroInitialization, arma::sp_mat>
+ *     p(trainData, trainLabels, 1000);
+ * p.Classify(testData, predictedLabels);
+ * @endcode
+ */
+class FeatureHasher
+{
+ public:
+  //! The largest number of bits allowed.  A perceptron on 2^28 dimensions
+  //! already needs 2 GiB of weights per class.
+  static const size_t MaxBits = 28;
+
+  /**
+   * Create a hasher into 2^bits dimensions.
+   *
+   * @param bits Number of bits of the hash used as the row of a feature (at
+   *     most MaxBits).
+   */
+  FeatureHasher(const size_t bits = 18) : bits(bits)
+  {
+    if (bits == 0 || bits > MaxBits)
+      Log::Fatal << "FeatureHasher: number of bits (" << bits << ") must be "
+          << "between 1 and " << (size_t) MaxBits << "!" << std::endl;
+    if (Dimensionality() > (size_t) std::numeric_limits<arma::uword>::max())
+      Log::Fatal << "FeatureHasher: 2^" << bits << " dimensions do not fit in "
+          << "arma::uword!" << std::endl;
+  }
+
+  //! Get the number of bits of the hash used as the row of a feature.
+  size_t Bits() const { return bits; }
+  //! Get the dimensionality of the hashed points.
+  size_t Dimensionality() const { return (size_t) 1 << bits; }
+
+  /**
+   * Find the row and the sign of the given feature.
+   *
+   * @param feature Name of the feature.
+   * @param sign Set to the sign (+1 or -1) the values of the feature take.
+   * @return The row of the feature.
+   */
+  size_t Index(const std::string& feature, double& sign) const
+  {
+    const uint64_t hash = Hash(feature);
+    sign = (hash >> 63) ? -1.0 : 1.0;
+    return (size_t) (hash & (Dimensionality() - 1));
+  }
+
+  /**
+   * Hash the given points, one column per point.
+   *
+   * @param points Points, each a string of "feature:value" tokens.
+   * @param data Sparse matrix to store the hashed points in.
+   */
+  void Transform(const std::vector<std::string>& points,
+                 arma::sp_mat& data) const
+  {
+    std::vector<arma::uword> rowIndices;
+    std::vector<arma::uword> columnPointers(1, 0);
+    std::vector<double> values;
+
+    // The values of the point being hashed, by row, so that collisions are
+    // summed and the rows come out sorted.
+    std::map<size_t, double> point;
+    for (size_t j = 0; j < points.size(); ++j)
+    {
+      point.clear();
+
+      std::istringstream tokens(points[j]);
+      std::string token;
+      while (tokens >> token)
+      {
+        double value = 1.0;
+        const size_t colon = token.rfind(':');
+        if (colon != std::string::npos)
+        {
+          const std::string valueString = token.substr(colon + 1);
+          char* end;
+          value = strtod(valueString.c_str(), &end);
+          if (valueString.empty() || *end != '\0')
+            Log::Fatal << "FeatureHasher: invalid value in token '" << token
+                << "' of point " << j << "!" << std::endl;
+          token.erase(colon);
+        }
+
+        double sign;
+        const size_t row = Index(token, sign);
+        point[row] += sign * value;
+      }
+
+      std::map<size_t, double>::const_iterator it = point.begin();
+      for ( ; it != point.end(); ++it)
+      {
+        if (it->second != 0.0)
+        {
+          rowIndices.push_back(it->first);
+          values.push_back(it->second);
+        }
+      }
+      columnPointers.push_back(rowIndices.size());
+    }
+
+    data = arma::sp_mat(arma::uvec(rowIndices), arma::uvec(columnPointers),
+        arma::vec(values), Dimensionality(), points.size());
+  }
+
+  /**
+   * Read and hash the points of the given file, which holds one point per
+   * line.
+   *
+   * @param filename File to read.
+   * @param data Sparse matrix to store the hashed points in.
+   */
+  void Load(const std::string& filename, arma::sp_mat& data) const
+  {
+    std::ifstream stream(filename.c_str());
+    if (!stream.is_open())
+      Log::Fatal << "FeatureHasher: cannot open '" << filename << "'!"
+          << std::endl;
+
+    std::vector<std::string> points;
+    std::string line;
+    while (std::getline(stream, line))
+      points.push_back(line);
+
+    Transform(points, data);
+  }
+
+  /**
+   * Compute the 64-bit FNV-1a hash of a string.
+   *
+   * @param feature String to hash.
+   */
+  static uint64_t Hash(const std::string& feature)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < feature.size(); ++i)
+    {
+      hash ^= (unsigned char) feature[i];
+      hash *= 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
+ private:
+  //! The number of bits of the hash used as the row of a feature.
+  size_t bits;
+};
+
+}; // namespace perceptron
+}; // namespace mlpack
+
+#endif
@@ -13,7 +13,7 @@ namespace mlpack {
 namespace perceptron {
 
 /**
- * This class is used to initialize weights for the weightVectors matrix in a
+ * This class is used to initialize the weights matrix and the biases in a
  * random manner.
  */
 class RandomInitialization
@@ -21,11 +21,28 @@ class RandomInitialization
  public:
   RandomInitialization() { }
 
-  inline static void Initialize(arma::mat& W,
-                                const size_t row,
-                                const size_t col)
+  /**
+   * Initialize the weights and biases uniformly at random in [0, 1].
+   *
+   * @param weights Weights matrix to initialize.
+   * @param biases Biases vector to initialize.
+   * @param numClasses Number of classes.
+   * @param dimensionality Number of dimensions of the data.
+   * @param classMajor If true, the weights have one class per column (the
+   *     weights of a class are contiguous); otherwise, one class per row.
+   */
+  template<typename eT>
+  inline static void Initialize(arma::Mat<eT>& weights,
+                                arma::Col<eT>& biases,
+                                const size_t numClasses,
+                                const size_t dimensionality,
+                                const bool classMajor = true)
   {
-    W = arma::randu<arma::mat>(row, col);
+    if (classMajor)
+      weights = arma::randu<arma::Mat<eT> >(dimensionality, numClasses);
+    else
+      weights = arma::randu<arma::Mat<eT> >(numClasses, dimensionality);
+    biases = arma::randu<arma::Col<eT> >(numClasses);
   }
 }; // class RandomInitialization
 
@@ -13,21 +13,35 @@ namespace mlpack {
 namespace perceptron {
 
 /**
- * This class is used to initialize the matrix weightVectors to zero.
+ * This class is used to initialize the weights matrix and the biases to zero.
  */
 class ZeroInitialization
 {
  public:
   ZeroInitialization() { }
 
-  inline static void Initialize(arma::mat& W,
-                                const size_t row,
-                                const size_t col)
+  /**
+   * Initialize the weights and biases to zero.
+   *
+   * @param weights Weights matrix to initialize.
+   * @param biases Biases vector to initialize.
+   * @param numClasses Number of classes.
+   * @param dimensionality Number of dimensions of the data.
+   * @param classMajor If true, the weights have one class per column (the
+   *     weights of a class are contiguous); otherwise, one class per row.
+   */
+  template<typename eT>
+  inline static void Initialize(arma::Mat<eT>& weights,
+                                arma::Col<eT>& biases,
+                                const size_t numClasses,
+                                const size_t dimensionality,
+                                const bool classMajor = true)
   {
-    arma::mat tempWeights(row, col);
-    tempWeights.fill(0.0);
-
-    W = tempWeights;
+    if (classMajor)
+      weights.zeros(dimensionality, numClasses);
+    else
+      weights.zeros(numClasses, dimensionality);
+    biases.zeros(numClasses);
   }
 }; // class ZeroInitialization
 
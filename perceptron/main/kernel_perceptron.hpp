@@ -0,0 +1,185 @@
+/**
+ * @file kernel_perceptron.hpp
+ * @author Udit Saxena
+ *
+ * Definition of KernelPerceptron class.
+ */
+#ifndef __MLPACK_METHODS_PERCEPTRON_KERNEL_PERCEPTRON_HPP
+#define __MLPACK_METHODS_PERCEPTRON_KERNEL_PERCEPTRON_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+
+#include <vector>
+
+#include "initialization_methods/zero_init.hpp"
+#include "initialization_methods/random_init.hpp"
+#include "learning_policies/simple_weight_update.hpp"
+#include "learning_policies/averaged_weight_update.hpp"
+#include "kernel_row_cache.hpp"
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * This class implements a kernel perceptron with a budget: a perceptron which
+ * learns in the feature space of a kernel, so it can fit data which is not
+ * linearly separable, while keeping at most a fixed number of support vectors.
+ *
+ * The score of class c for a point x is
+ *
+ *   score_c(x) = sum_s a(s, c) K(v_s, x) + b_c,
+ *
+ * where v_s is the support vector held in slot s.  This is the score of a
+ * linear perceptron whose attributes are the kernel values K(v_s, x), with the
+ * coefficients a as its weights matrix (one class per column) and the biases
+ * b, so the coefficients are initialized by the WeightInitializationPolicy and
+ * updated by the LearnPolicy, as the weights of a Perceptron are.  When a
+ * point x is misclassified, it becomes a support vector (unless it is one
+ * already), and the LearnPolicy updates the coefficients of its slot.
+ *
+ * Once the budget is full, a new support vector replaces the one whose
+ * coefficients have the smallest norm, which the LearnPolicy forgets with
+ * ClearAttribute().  Training and classifying a point therefore cost at most
+ * budget kernel evaluations, however many mistakes are made.
+ *
+ * During training, the kernel values of the most recently used training
+ * points are kept in an LRU cache of cacheSize rows.  When a slot is given a
+ * new support vector, only that entry of each cached row is recomputed.  If
+ * the whole training set fits in the cache, each epoch after the first costs
+ * one kernel evaluation per cached row for each new support vector.
+ *
+ * @tparam KernelType Kernel to use (such as kernel::GaussianKernel); it must
+ *      have an Evaluate(a, b) function.
+ * @tparam LearnPolicy Options of SimpleWeightUpdate and AveragedWeightUpdate.
+ * @tparam WeightInitializationPolicy Option of ZeroInitialization and
+ *      RandomInitialization.
+ */
+template<typename KernelType = kernel::GaussianKernel,
+         typename LearnPolicy = SimpleWeightUpdate,
+         typename WeightInitializationPolicy = ZeroInitialization>
+class KernelPerceptron
+{
+ public:
+  /**
+   * Constructor - trains the kernel perceptron on the given data.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of dataset.
+   * @param iterations Maximum number of iterations for the perceptron learning
+   *     algorithm.
+   * @param budget Maximum number of support vectors.
+   * @param cacheSize Maximum number of rows of kernel values cached during
+   *     training (one per training point).
+   * @param kernel Instantiated kernel (for kernels with parameters).
+   * @param threads Number of threads used for classification; 0 means the
+   *     OpenMP default.
+   */
+  KernelPerceptron(const arma::mat& data,
+                   const arma::Row<size_t>& labels,
+                   int iterations,
+                   const size_t budget = 1000,
+                   const size_t cacheSize = 1024,
+                   KernelType kernel = KernelType(),
+                   const size_t threads = 1);
+
+  /**
+   * Classification function. After training, use the support vectors, their
+   * coefficients and the biases to classify test, and put the predicted
+   * classes in predictedLabels.  The kernel values of a block of test points
+   * are computed together, and the scores of the block come from a single
+   * matrix product.  Blocks are classified in parallel (with the number of
+   * threads given at construction), if OpenMP is available.
+   *
+   * @param test Testing data or data to classify.
+   * @param predictedLabels Vector to store the predicted classes after
+   *     classifying test.
+   */
+  void Classify(const arma::mat& test,
+                arma::Row<size_t>& predictedLabels) const;
+
+  //! Get the number of support vectors.
+  size_t NumSupportVectors() const { return numSupportVectors; }
+  //! Get the maximum number of support vectors.
+  size_t Budget() const { return supportVectors.n_cols; }
+
+  //! Get the support vectors (the first NumSupportVectors() columns are used).
+  const arma::mat& SupportVectors() const { return supportVectors; }
+  //! Get the coefficients of each support vector (row) for each class
+  //! (column).
+  const arma::mat& Coefficients() const { return coefficients; }
+  //! Get the bias of each class.
+  const arma::vec& Biases() const { return biases; }
+
+  //! Get the kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the kernel.
+  KernelType& Kernel() { return kernel; }
+
+ private:
+  //! To store the number of iterations.
+  size_t iter;
+
+  //! Number of rows of kernel values cached during training.
+  size_t cacheSize;
+
+  //! The kernel.
+  KernelType kernel;
+
+  //! The support vectors (one per column; one column per slot of the budget).
+  arma::mat supportVectors;
+
+  //! The number of slots which hold a support vector.
+  size_t numSupportVectors;
+
+  //! The coefficients of each slot (row) for each class (column).
+  arma::mat coefficients;
+
+  //! Stores the bias of each class.
+  arma::vec biases;
+
+  //! Number of threads used for classification.
+  int numThreads;
+
+  /**
+   * Train function.  Go over the training data until every point is classified
+   * correctly, or the maximum number of iterations is reached, making each
+   * misclassified point a support vector and updating its coefficients with
+   * the LearnPolicy.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of dataset.
+   */
+  void Train(const arma::mat& data, const arma::Row<size_t>& labels);
+
+  /**
+   * Find the slot for a new support vector: the next free slot, or, once the
+   * budget is full, the slot of the support vector whose coefficients have the
+   * smallest norm.
+   */
+  size_t FindSlot() const;
+
+  /**
+   * Compute the kernel values of a point with every support vector.
+   *
+   * @param point Point to evaluate the kernel on.
+   * @param row Array to store the kernel value of each slot in.
+   */
+  void KernelRow(const arma::vec& point, double* row) const;
+
+  /**
+   * Find the class with the largest score for a point, given its kernel values
+   * with the support vectors; ties go to the lowest class.
+   *
+   * @param row Kernel value of each slot.
+   * @param scores Vector to store the score of each class in.
+   */
+  size_t Predict(const double* row, arma::vec& scores) const;
+};
+
+}; // namespace perceptron
+}; // namespace mlpack
+
+#include "kernel_perceptron_impl.hpp"
+
+#endif
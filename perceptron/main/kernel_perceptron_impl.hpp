@@ -0,0 +1,328 @@
+/**
+ * @file kernel_perceptron_impl.hpp
+ * @author Udit Saxena
+ *
+ * Implementation of KernelPerceptron class.
+ */
+#ifndef __MLPACK_METHODS_PERCEPTRON_KERNEL_PERCEPTRON_IMPL_HPP
+#define __MLPACK_METHODS_PERCEPTRON_KERNEL_PERCEPTRON_IMPL_HPP
+
+#include "kernel_perceptron.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * Constructor - trains the kernel perceptron.  The coefficients of every slot
+ * of the budget are initialized by the WeightInitializationPolicy, as the
+ * weights of a perceptron with budget attributes.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of dataset.
+ * @param iterations Maximum number of iterations for the perceptron learning
+ *      algorithm.
+ * @param budget Maximum number of support vectors.
+ * @param cacheSize Number of rows of kernel values cached during training.
+ * @param kernel Instantiated kernel.
+ * @param threads Number of threads used for classification (0 means the
+ *      OpenMP default).
+ */
+template<
+    typename KernelType,
+    typename LearnPolicy,
+    typename WeightInitializationPolicy
+>
+KernelPerceptron<KernelType, LearnPolicy, WeightInitializationPolicy>::
+KernelPerceptron(const arma::mat& data,
+                 const arma::Row<size_t>& labels,
+                 int iterations,
+                 const size_t budget,
+                 const size_t cacheSize,
+                 KernelType kernel,
+                 const size_t threads) :
+    iter(iterations),
+    cacheSize(cacheSize),
+    kernel(kernel),
+    numSupportVectors(0)
+{
+  if (budget == 0)
+    Log::Fatal << "KernelPerceptron: budget must be positive!" << std::endl;
+  if (labels.n_elem != data.n_cols)
+    Log::Fatal << "KernelPerceptron: number of labels (" << labels.n_elem
+        << ") does not match number of points (" << data.n_cols << ")!"
+        << std::endl;
+  if (data.n_cols == 0)
+    Log::Fatal << "KernelPerceptron: no training points!" << std::endl;
+
+#ifdef _OPENMP
+  numThreads = (threads == 0) ? omp_get_max_threads() : (int) threads;
+#else
+  numThreads = (threads == 0) ? 1 : (int) threads;
+#endif
+
+  supportVectors.set_size(data.n_rows, budget);
+
+  WeightInitializationPolicy WIP;
+  WIP.Initialize(coefficients, biases, arma::max(labels) + 1, budget);
+
+  // Start training.
+  Train(data, labels);
+}
+
+/**
+ * Classification function.  The kernel values of each block of test points
+ * with the support vectors are computed, and the scores of every class for the
+ * block come from a single matrix product with the coefficients.  Blocks are
+ * classified in parallel by numThreads threads, if OpenMP is available.
+ *
+ * @param test testing data or data to classify.
+ * @param predictedLabels vector to store the predicted classes after
+ *      classifying test
+ */
+template<
+    typename KernelType,
+    typename LearnPolicy,
+    typename WeightInitializationPolicy
+>
+void KernelPerceptron<KernelType, LearnPolicy, WeightInitializationPolicy>::
+Classify(const arma::mat& test, arma::Row<size_t>& predictedLabels) const
+{
+  if (test.n_rows != supportVectors.n_rows)
+    Log::Fatal << "KernelPerceptron: test data dimensionality (" << test.n_rows
+        << ") does not match model dimensionality (" << supportVectors.n_rows
+        << ")!" << std::endl;
+
+  const size_t numClasses = biases.n_elem;
+  predictedLabels.set_size(test.n_cols);
+
+  const size_t blockSize = 512;
+  const int numBlocks = (test.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+    // The kernel values and scores of each block; reused by every block this
+    // thread handles.
+    arma::mat kernels, scores;
+
+    #pragma omp for schedule(static)
+    for (int block = 0; block < numBlocks; block++)
+    {
+      const size_t begin = block * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) test.n_cols);
+
+      kernels.set_size(numSupportVectors, end - begin);
+      for (size_t i = begin; i < end; ++i)
+        KernelRow(test.unsafe_col(i), kernels.colptr(i - begin));
+
+      if (numSupportVectors > 0)
+        scores = coefficients.rows(0, numSupportVectors - 1).t() * kernels;
+      else
+        scores.zeros(numClasses, end - begin);
+      scores.each_col() += biases;
+
+      // Take the class with the largest score; ties go to the lowest class.
+      for (size_t i = 0; i < end - begin; ++i)
+      {
+        const double* score = scores.colptr(i);
+        size_t best = 0;
+        for (size_t c = 1; c < numClasses; ++c)
+          if (score[c] > score[best])
+            best = c;
+
+        predictedLabels[begin + i] = best;
+      }
+    }
+  }
+}
+
+/**
+ * Training function.  The kernel values of each training point with the
+ * support vectors are taken from the cache when they are there; when a slot is
+ * given a new support vector, that entry of every cached row is recomputed, so
+ * that the cached rows stay up to date.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of dataset.
+ */
+template<
+    typename KernelType,
+    typename LearnPolicy,
+    typename WeightInitializationPolicy
+>
+void KernelPerceptron<KernelType, LearnPolicy, WeightInitializationPolicy>::
+Train(const arma::mat& data, const arma::Row<size_t>& labels)
+{
+  const size_t budget = supportVectors.n_cols;
+
+  // The slot of each training point which is a support vector (budget if it is
+  // not one), and the training point held by each slot.
+  std::vector<size_t> pointSlot(data.n_cols, budget);
+  std::vector<size_t> slotPoint(budget);
+
+  // There is no use for more rows than training points.
+  KernelRowCache cache(std::min(cacheSize, (size_t) data.n_cols), budget);
+
+  // The update of a misclassified point is the indicator vector of its slot.
+  arma::vec update(budget);
+  update.zeros();
+  arma::vec scores(biases.n_elem);
+
+  size_t i = 0;
+  bool converged = false;
+
+  LearnPolicy LP;
+  LP.StartTraining(coefficients, biases);
+  while ((i < iter) && (!converged))
+  {
+    // This outer loop is for each iteration, and we use the 'converged'
+    // variable for noting whether or not convergence has been reached.
+    i++;
+    converged = true;
+
+    for (size_t j = 0; j < data.n_cols; j++)
+    {
+      double* row = cache.Find(j);
+      if (row == NULL)
+      {
+        row = cache.Insert(j);
+        KernelRow(data.unsafe_col(j), row);
+      }
+
+      const size_t predicted = Predict(row, scores);
+      if (predicted != labels(0, j))
+      {
+        converged = false;
+
+        size_t slot = pointSlot[j];
+        if (slot == budget)
+        {
+          // Make the point a support vector, evicting another one if the
+          // budget is full.
+          slot = FindSlot();
+          if (slot < numSupportVectors)
+          {
+            pointSlot[slotPoint[slot]] = budget;
+            LP.ClearAttribute(slot, coefficients);
+          }
+          else
+          {
+            numSupportVectors++;
+          }
+
+          supportVectors.col(slot) = data.col(j);
+          slotPoint[slot] = j;
+          pointSlot[j] = slot;
+
+          // Update the entry of the slot in every cached row (including the
+          // row of this point).
+          for (size_t r = 0; r < cache.Size(); ++r)
+            cache.Row(r)[slot] = kernel.Evaluate(
+                supportVectors.unsafe_col(slot),
+                data.unsafe_col(cache.Key(r)));
+        }
+
+        update[slot] = 1.0;
+        LP.UpdateWeights(update, coefficients, biases, predicted,
+            labels(0, j));
+        update[slot] = 0.0;
+      }
+
+      LP.NextPoint();
+    }
+  }
+  LP.FinishTraining(coefficients, biases);
+}
+
+/**
+ * Find the slot for a new support vector.  Once the budget is full, the
+ * support vector with the smallest coefficients contributes least to the
+ * scores, so it is the one evicted.
+ */
+template<
+    typename KernelType,
+    typename LearnPolicy,
+    typename WeightInitializationPolicy
+>
+size_t KernelPerceptron<KernelType, LearnPolicy, WeightInitializationPolicy>::
+FindSlot() const
+{
+  if (numSupportVectors < supportVectors.n_cols)
+    return numSupportVectors;
+
+  size_t smallest = 0;
+  double smallestNorm = 0.0;
+  for (size_t s = 0; s < numSupportVectors; ++s)
+  {
+    double norm = 0.0;
+    for (size_t c = 0; c < coefficients.n_cols; ++c)
+      norm += coefficients(s, c) * coefficients(s, c);
+
+    if (s == 0 || norm < smallestNorm)
+    {
+      smallest = s;
+      smallestNorm = norm;
+    }
+  }
+
+  return smallest;
+}
+
+/**
+ * Compute the kernel values of a point with every support vector.
+ *
+ * @param point Point to evaluate the kernel on.
+ * @param row Array to store the kernel value of each slot in.
+ */
+template<
+    typename KernelType,
+    typename LearnPolicy,
+    typename WeightInitializationPolicy
+>
+void KernelPerceptron<KernelType, LearnPolicy, WeightInitializationPolicy>::
+KernelRow(const arma::vec& point, double* row) const
+{
+  for (size_t s = 0; s < numSupportVectors; ++s)
+    row[s] = kernel.Evaluate(supportVectors.unsafe_col(s), point);
+}
+
+/**
+ * Find the class with the largest score for a point, given its kernel values
+ * with the support vectors.
+ *
+ * @param row Kernel value of each slot.
+ * @param scores Vector to store the score of each class in.
+ */
+template<
+    typename KernelType,
+    typename LearnPolicy,
+    typename WeightInitializationPolicy
+>
+size_t KernelPerceptron<KernelType, LearnPolicy, WeightInitializationPolicy>::
+Predict(const double* row, arma::vec& scores) const
+{
+  size_t best = 0;
+  for (size_t c = 0; c < biases.n_elem; ++c)
+  {
+    const double* coefficient = coefficients.colptr(c);
+    scores[c] = biases[c];
+    for (size_t s = 0; s < numSupportVectors; ++s)
+      scores[c] += coefficient[s] * row[s];
+
+    if (scores[c] > scores[best])
+      best = c;
+  }
+
+  return best;
+}
+
+}; // namespace perceptron
+}; // namespace mlpack
+
+#endif
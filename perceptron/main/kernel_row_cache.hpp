@@ -0,0 +1,135 @@
+/**
+ * @file kernel_row_cache.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the KernelRowCache class, a least-recently-used cache of rows
+ * of kernel evaluations.
+ */
+#ifndef __MLPACK_METHODS_PERCEPTRON_KERNEL_ROW_CACHE_HPP
+#define __MLPACK_METHODS_PERCEPTRON_KERNEL_ROW_CACHE_HPP
+
+#include <mlpack/core.hpp>
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * This class caches a bounded number of rows of kernel evaluations, each
+ * identified by a key (such as the index of a training point), and evicts the
+ * least recently used row when it is full.  The rows are stored in a matrix
+ * allocated once (one row per column), so the memory used is fixed by the
+ * capacity and the length of a row, and a pointer to a row stays valid until
+ * that row is evicted.
+ *
+ * @code
+ * double* row = cache.Find(key);
+ * if (row == NULL)
+ * {
+ *   row = cache.Insert(key);
+ *   // Fill row.
+ * }
+ * @endcode
+ */
+class KernelRowCache
+{
+ public:
+  /**
+   * Create an empty cache.
+   *
+   * @param capacity Maximum number of rows held.
+   * @param rowLength Number of values in each row.
+   */
+  KernelRowCache(const size_t capacity, const size_t rowLength) :
+      rows(rowLength, capacity),
+      keys(capacity),
+      positions(capacity),
+      numRows(0)
+  {
+    if (capacity == 0)
+      Log::Fatal << "KernelRowCache: capacity must be positive!" << std::endl;
+  }
+
+  /**
+   * Find the row of the given key, and mark it as the most recently used.
+   *
+   * @param key Key of the row.
+   * @return The row, or NULL if it is not cached.
+   */
+  double* Find(const size_t key)
+  {
+    std::map<size_t, size_t>::const_iterator it = slots.find(key);
+    if (it == slots.end())
+      return NULL;
+
+    // Move the row to the front of the usage order.
+    order.splice(order.begin(), order, positions[it->second]);
+    return rows.colptr(it->second);
+  }
+
+  /**
+   * Make room for the row of the given key, which must not be cached already,
+   * evicting the least recently used row if the cache is full.  The values of
+   * the new row are left to the caller to fill.
+   *
+   * @param key Key of the row.
+   * @return The (uninitialized) row.
+   */
+  double* Insert(const size_t key)
+  {
+    size_t slot;
+    if (numRows < keys.size())
+    {
+      slot = numRows++;
+      order.push_front(slot);
+    }
+    else
+    {
+      // Reuse the slot of the least recently used row.
+      slot = order.back();
+      slots.erase(keys[slot]);
+      order.splice(order.begin(), order, positions[slot]);
+    }
+
+    keys[slot] = key;
+    positions[slot] = order.begin();
+    slots[key] = slot;
+
+    return rows.colptr(slot);
+  }
+
+  //! Get the number of rows held.
+  size_t Size() const { return numRows; }
+
+  //! Get the key of the i'th row held (in no particular order).
+  size_t Key(const size_t i) const { return keys[i]; }
+  //! Get the i'th row held (in no particular order).
+  double* Row(const size_t i) { return rows.colptr(i); }
+
+ private:
+  //! The rows (one per column).
+  arma::mat rows;
+
+  //! The key of the row in each slot.
+  std::vector<size_t> keys;
+
+  //! The position of each slot in the usage order.
+  std::vector<std::list<size_t>::iterator> positions;
+
+  //! The slots, from the most recently used to the least recently used.
+  std::list<size_t> order;
+
+  //! The slot of each key held.
+  std::map<size_t, size_t> slots;
+
+  //! The number of rows held.
+  size_t numRows;
+};
+
+}; // namespace perceptron
+}; // namespace mlpack
+
+#endif
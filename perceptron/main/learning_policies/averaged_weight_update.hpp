@@ -0,0 +1,206 @@
+/**
+ * @file averaged_weight_update.hpp
+ * @author Udit Saxena
+ *
+ * Averaged weight update rule for the perceptron.
+ */
+#ifndef _MLPACK_METHODS_PERCEPTRON_LEARNING_POLICIES_AVERAGED_WEIGHT_UPDATE_HPP
+#define _MLPACK_METHODS_PERCEPTRON_LEARNING_POLICIES_AVERAGED_WEIGHT_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+
+/**
+ * This class updates the weights matrix with the same rule as
+ * SimpleWeightUpdate, but the perceptron ends up with the average of the
+ * weights it had after each training point, rather than with the last ones.
+ * The averaged perceptron generalizes better than the plain one when the data
+ * is not linearly separable, and it needs fewer iterations to do so.
+ *
+ * The average is kept lazily: besides the weights w, the policy accumulates
+ * u, the sum of every update scaled by the number c of the point that made it.
+ * The average is then w - u / c, so each mistake costs O(d), and a point which
+ * is classified correctly costs nothing more than incrementing c.  The sums
+ * are kept in double precision whatever the element type of the weights, since
+ * the scaled updates grow with the number of points.
+ */
+namespace mlpack {
+namespace perceptron {
+
+class AveragedWeightUpdate
+{
+ public:
+  //! Create the policy.  StartTraining() must be called before any update.
+  AveragedWeightUpdate() : counter(1) { }
+
+  /**
+   * Get ready to average the weights from the given starting point.
+   *
+   * @param weights Initial weights of the perceptron.
+   * @param biases Initial biases of the perceptron.
+   */
+  template<typename eT>
+  void StartTraining(const arma::Mat<eT>& weights, const arma::Col<eT>& biases)
+  {
+    weightSum.zeros(weights.n_rows, weights.n_cols);
+    biasSum.zeros(biases.n_elem);
+    counter = 1;
+  }
+
+  /**
+   * This function is called to update the weights matrix.  It updates the
+   * weights and biases like SimpleWeightUpdate does, and accumulates the update
+   * for the average.
+   *
+   * @param trainingPoint Point which has been incorrectly classified.
+   * @param weights Weights matrix (one class per column).
+   * @param biases Bias of each class.
+   * @param incorrectClass Index of the class which has been incorrectly
+   *     predicted.
+   * @param correctClass Index of the class which should have been predicted.
+   * @param instanceWeight Weight of the point; the update is scaled by it.
+   */
+  template<typename VecType, typename eT>
+  void UpdateWeights(const VecType& trainingPoint,
+                     arma::Mat<eT>& weights,
+                     arma::Col<eT>& biases,
+                     const size_t incorrectClass,
+                     const size_t correctClass,
+                     const double instanceWeight = 1.0)
+  {
+    const eT weight = (eT) instanceWeight;
+
+    weights.col(incorrectClass) -= weight * trainingPoint;
+    biases(incorrectClass) -= weight;
+
+    weights.col(correctClass) += weight * trainingPoint;
+    biases(correctClass) += weight;
+
+    const double scaledWeight = counter * instanceWeight;
+    double* incorrectSum = weightSum.colptr(incorrectClass);
+    double* correctSum = weightSum.colptr(correctClass);
+    for (size_t i = 0; i < trainingPoint.n_elem; ++i)
+    {
+      incorrectSum[i] -= scaledWeight * trainingPoint[i];
+      correctSum[i] += scaledWeight * trainingPoint[i];
+    }
+
+    biasSum(incorrectClass) -= scaledWeight;
+    biasSum(correctClass) += scaledWeight;
+  }
+
+  /**
+   * Update the weights matrix for a sparse point, touching only the weights
+   * (and the accumulated updates) of the nonzero attributes of the point.
+   *
+   * @param trainingPoint Point which has been incorrectly classified.
+   * @param weights Weights matrix (one class per row, as the Perceptron
+   *     keeps them for sparse data).
+   * @param biases Bias of each class.
+   * @param incorrectClass Index of the class which has been incorrectly
+   *     predicted.
+   * @param correctClass Index of the class which should have been predicted.
+   * @param instanceWeight Weight of the point; the update is scaled by it.
+   */
+  template<typename eT>
+  void UpdateWeights(const arma::SpSubview<eT>& trainingPoint,
+                     arma::Mat<eT>& weights,
+                     arma::Col<eT>& biases,
+                     const size_t incorrectClass,
+                     const size_t correctClass,
+                     const double instanceWeight = 1.0)
+  {
+    const eT weight = (eT) instanceWeight;
+    const double scaledWeight = counter * instanceWeight;
+
+    typename arma::SpSubview<eT>::const_iterator it = trainingPoint.begin();
+    for ( ; it != trainingPoint.end(); ++it)
+    {
+      weights(incorrectClass, it.row()) -= weight * (*it);
+      weights(correctClass, it.row()) += weight * (*it);
+
+      weightSum(incorrectClass, it.row()) -= scaledWeight * (*it);
+      weightSum(correctClass, it.row()) += scaledWeight * (*it);
+    }
+
+    biases(incorrectClass) -= weight;
+    biases(correctClass) += weight;
+
+    biasSum(incorrectClass) -= scaledWeight;
+    biasSum(correctClass) += scaledWeight;
+  }
+
+  /**
+   * Apply the updates of several misclassified points at once, with a single
+   * rank-k update, and accumulate it for the average.
+   *
+   * @param trainingPoints Points which have been incorrectly classified (one
+   *     per column).
+   * @param weights Weights matrix (one class per column).
+   * @param biases Bias of each class.
+   * @param coefficients Coefficient of each point (column) for each class
+   *     (row).
+   */
+  template<typename eT>
+  void BatchUpdateWeights(const arma::Mat<eT>& trainingPoints,
+                          arma::Mat<eT>& weights,
+                          arma::Col<eT>& biases,
+                          const arma::Mat<eT>& coefficients)
+  {
+    const arma::Mat<eT> weightUpdate = trainingPoints * coefficients.t();
+    const arma::Col<eT> biasUpdate = arma::sum(coefficients, 1);
+
+    weights += weightUpdate;
+    biases += biasUpdate;
+
+    weightSum += counter * arma::conv_to<arma::mat>::from(weightUpdate);
+    biasSum += counter * arma::conv_to<arma::vec>::from(biasUpdate);
+  }
+
+  //! Move on to the next training point.
+  void NextPoint() { counter++; }
+
+  /**
+   * Forget the weights of the given attribute, for every class, along with
+   * their accumulated updates, so that the attribute starts again from zero in
+   * the average too.  This is used by KernelPerceptron when a support vector
+   * is evicted.
+   *
+   * @param attribute Attribute (row of the weights) to forget.
+   * @param weights Weights matrix (one class per column).
+   */
+  template<typename eT>
+  void ClearAttribute(const size_t attribute, arma::Mat<eT>& weights)
+  {
+    weights.row(attribute).zeros();
+    weightSum.row(attribute).zeros();
+  }
+
+  /**
+   * Replace the weights and biases with their average over every training
+   * point seen since StartTraining().
+   *
+   * @param weights Weights of the perceptron.
+   * @param biases Biases of the perceptron.
+   */
+  template<typename eT>
+  void FinishTraining(arma::Mat<eT>& weights, arma::Col<eT>& biases)
+  {
+    weights -= arma::conv_to<arma::Mat<eT> >::from(weightSum / counter);
+    biases -= arma::conv_to<arma::Col<eT> >::from(biasSum / counter);
+  }
+
+ private:
+  //! The sum of the weight updates, each scaled by the number of its point.
+  arma::mat weightSum;
+
+  //! The sum of the bias updates, each scaled by the number of its point.
+  arma::vec biasSum;
+
+  //! The number of the current training point, starting from 1.
+  double counter;
+};
+
+}; // namespace perceptron
+}; // namespace mlpack
+
+#endif
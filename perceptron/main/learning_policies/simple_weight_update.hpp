@@ -10,7 +10,7 @@
 #include <mlpack/core.hpp>
 
 /**
- * This class is used to update the weightVectors matrix according to the simple
+ * This class is used to update the weights matrix according to the simple
  * update rule as discussed by Rosenblatt:
  *
  *  if a vector x has been incorrectly classified by a weight w,
@@ -25,29 +25,122 @@ namespace perceptron {
 class SimpleWeightUpdate
 {
  public:
+  //! Called before training starts; the simple rule keeps no state.
+  template<typename eT>
+  void StartTraining(const arma::Mat<eT>& /* weights */,
+                     const arma::Col<eT>& /* biases */) { }
+
+  /**
+   * This function is called to update the weights matrix.  It decreases the
+   * weights of the incorrectly classified class while increasing the weight of
+   * the correct class it should have been classified to.  The biases are the
+   * weights of an implicit constant input of 1, and are updated in the same
+   * way.
+   *
+   * @param trainingPoint Point which has been incorrectly classified.
+   * @param weights Matrix of weights (one class per column).
+   * @param biases Bias of each class.
+   * @param incorrectClass Index of the class which has been incorrectly
+   *     predicted.
+   * @param correctClass Index of the class which should have been predicted.
+   * @param instanceWeight Weight of the point; the update is scaled by it.
+   */
+  template<typename VecType, typename eT>
+  void UpdateWeights(const VecType& trainingPoint,
+                     arma::Mat<eT>& weights,
+                     arma::Col<eT>& biases,
+                     const size_t incorrectClass,
+                     const size_t correctClass,
+                     const double instanceWeight = 1.0)
+  {
+    const eT weight = (eT) instanceWeight;
+
+    weights.col(incorrectClass) -= weight * trainingPoint;
+    biases(incorrectClass) -= weight;
+
+    weights.col(correctClass) += weight * trainingPoint;
+    biases(correctClass) += weight;
+  }
+
+  /**
+   * Update the weights matrix for a sparse point.  The update is the same as
+   * for a dense point, but only the weights of the nonzero attributes of the
+   * point are touched.
+   *
+   * @param trainingPoint Point which has been incorrectly classified.
+   * @param weights Weights matrix (one class per row, as the Perceptron
+   *     keeps them for sparse data).
+   * @param biases Bias of each class.
+   * @param incorrectClass Index of the class which has been incorrectly
+   *     predicted.
+   * @param correctClass Index of the class which should have been predicted.
+   * @param instanceWeight Weight of the point; the update is scaled by it.
+   */
+  template<typename eT>
+  void UpdateWeights(const arma::SpSubview<eT>& trainingPoint,
+                     arma::Mat<eT>& weights,
+                     arma::Col<eT>& biases,
+                     const size_t incorrectClass,
+                     const size_t correctClass,
+                     const double instanceWeight = 1.0)
+  {
+    const eT weight = (eT) instanceWeight;
+
+    typename arma::SpSubview<eT>::const_iterator it = trainingPoint.begin();
+    for ( ; it != trainingPoint.end(); ++it)
+    {
+      weights(incorrectClass, it.row()) -= weight * (*it);
+      weights(correctClass, it.row()) += weight * (*it);
+    }
+
+    biases(incorrectClass) -= weight;
+    biases(correctClass) += weight;
+  }
+
   /**
-   * This function is called to update the weightVectors matrix.
-   *  It decreases the weights of the incorrectly classified class while
-   * increasing the weight of the correct class it should have been classified to.
+   * Apply the updates of several misclassified points at once: the weights of
+   * each class are changed by the sum of the points, each scaled by its
+   * coefficient for that class.  This is a single rank-k update.
    *
-   * @param trainData The training dataset.
-   * @param weightVectors Matrix of weight vectors.
-   * @param rowIndex Index of the row which has been incorrectly predicted.
-   * @param labelIndex Index of the vector in trainData.
-   * @param vectorIndex Index of the class which should have been predicted.
+   * @param trainingPoints Points which have been incorrectly classified (one
+   *     per column).
+   * @param weights Weights matrix (one class per column).
+   * @param biases Bias of each class.
+   * @param coefficients Coefficient of each point (column) for each class
+   *     (row); the (weighted) update of a point is -1 for the predicted class
+   *     and +1 for the correct class.
    */
-  void UpdateWeights(const arma::mat& trainData,
-                     arma::mat& weightVectors,
-                     const size_t labelIndex,
-                     const size_t vectorIndex,
-                     const size_t rowIndex)
+  template<typename eT>
+  void BatchUpdateWeights(const arma::Mat<eT>& trainingPoints,
+                          arma::Mat<eT>& weights,
+                          arma::Col<eT>& biases,
+                          const arma::Mat<eT>& coefficients)
   {
-    weightVectors.row(rowIndex) = weightVectors.row(rowIndex) - 
-                                  trainData.col(labelIndex).t();
+    weights += trainingPoints * coefficients.t();
+    biases += arma::sum(coefficients, 1);
+  }
 
-    weightVectors.row(vectorIndex) = weightVectors.row(vectorIndex) +
-                                     trainData.col(labelIndex).t();
+  //! Called after each training point; the simple rule keeps no state.
+  void NextPoint() { }
+
+  /**
+   * Forget the weights of the given attribute, for every class.  This is used
+   * by KernelPerceptron when a support vector is evicted, and its slot given
+   * to a new one.
+   *
+   * @param attribute Attribute (row of the weights) to forget.
+   * @param weights Weights matrix (one class per column).
+   */
+  template<typename eT>
+  void ClearAttribute(const size_t attribute, arma::Mat<eT>& weights)
+  {
+    weights.row(attribute).zeros();
   }
+
+  //! Called once training is done; the last weights are kept as they are.
+  template<typename eT>
+  void FinishTraining(arma::Mat<eT>& /* weights */,
+                      arma::Col<eT>& /* biases */) { }
 };
 
 }; // namespace perceptron
@@ -9,9 +9,12 @@
 
 #include <mlpack/core.hpp>
 
+#include <vector>
+
 #include "initialization_methods/zero_init.hpp"
 #include "initialization_methods/random_init.hpp"
 #include "learning_policies/simple_weight_update.hpp"
+#include "learning_policies/averaged_weight_update.hpp"
 
 namespace mlpack {
 namespace perceptron {
@@ -21,7 +24,25 @@ namespace perceptron {
  * network).  It converges if the supplied training dataset is linearly
  * separable.
  *
- * @tparam LearnPolicy Options of SimpleWeightUpdate and GradientDescent.
+ * The weights have the element type of MatType, so a perceptron trained on
+ * arma::fmat data keeps single-precision weights, which halves the memory and
+ * bandwidth of training and classification.
+ *
+ * The data may be dense (arma::mat) or sparse (arma::sp_mat).  With sparse
+ * data, points are scored from their nonzeros only, and the weight updates of
+ * the LearnPolicy only touch the weights of the nonzero attributes, so the cost
+ * of a point does not depend on the dimensionality.
+ *
+ * The layout of the weights depends on the data (see ClassMajor).  For dense
+ * data, the weights of each class are stored contiguously (one class per
+ * column), so an update only touches the cache lines of the two classes
+ * involved, however many classes there are.  For sparse data, the weights of
+ * each attribute are stored contiguously (one class per row), so each nonzero
+ * of a point is scored from one contiguous run of weights, and an update
+ * touches the same number of weights under either layout.
+ *
+ * @tparam LearnPolicy Options of SimpleWeightUpdate, AveragedWeightUpdate and
+ *      GradientDescent.
  * @tparam WeightInitializationPolicy Option of ZeroInitialization and
  *      RandomInitialization.
  */
@@ -31,53 +52,330 @@ template<typename LearnPolicy = SimpleWeightUpdate,
 class Perceptron
 {
  public:
+  //! The element type of the data, and of the weights.
+  typedef typename MatType::elem_type ElemType;
+
+  //! True if the weights have one class per column (for dense data), false if
+  //! they have one class per row (for sparse data).
+  static const bool ClassMajor = !arma::is_SpMat<MatType>::value;
+
   /**
-   * Constructor - constructs the perceptron by building the weightVectors
-   * matrix, which is later used in Classification.  It adds a bias input vector
-   * of 1 to the input data to take care of the bias weights.
+   * Constructor - constructs the perceptron by building the weights matrix and
+   * the biases vector, which are later used in Classification.  The bias is
+   * handled implicitly (as a weight for a constant input of 1), so the data is
+   * neither copied nor modified.
    *
    * @param data Input, training data.
    * @param labels Labels of dataset.
    * @param iterations Maximum number of iterations for the perceptron learning
    *     algorithm.
+   * @param threads Number of threads used for training and classification; 0
+   *     means the OpenMP default.  With more than one thread, the perceptron is
+   *     trained by iterative parameter mixing.
+   * @param batchSize Number of points scored together during training.  With
+   *     more than one point per batch, the updates of the points of a batch
+   *     which are misclassified are applied together, after the whole batch
+   *     has been scored.
+   */
+  Perceptron(const MatType& data,
+             const arma::Row<size_t>& labels,
+             int iterations,
+             const size_t threads = 1,
+             const size_t batchSize = 1);
+
+  /**
+   * Construct an untrained perceptron, with weights given by the
+   * WeightInitializationPolicy.  It can then be trained incrementally with
+   * Train().
+   *
+   * @param numClasses Number of classes.
+   * @param dimensionality Number of attributes of the data.
+   * @param iterations Maximum number of iterations used by the boosting
+   *     constructor.
+   * @param threads Number of threads used for training and classification; 0
+   *     means the OpenMP default.
+   * @param batchSize Number of points scored together during training.
+   */
+  Perceptron(const size_t numClasses,
+             const size_t dimensionality,
+             int iterations,
+             const size_t threads = 1,
+             const size_t batchSize = 1);
+
+  /**
+   * Construct a perceptron from pre-trained weights and biases, such as those
+   * of another perceptron (see Weights() and Biases()).  It can classify
+   * points right away, and its training can be continued with Train().
+   *
+   * @param weights Weights of each class (one class per column, or per row for
+   *     sparse data; see ClassMajor).
+   * @param biases Bias of each class.
+   * @param iterations Maximum number of iterations used by the boosting
+   *     constructor.
+   * @param threads Number of threads used for training and classification; 0
+   *     means the OpenMP default.
+   * @param batchSize Number of points scored together during training.
    */
-  Perceptron(const MatType& data, const arma::Row<size_t>& labels, int iterations);
+  Perceptron(const arma::Mat<ElemType>& weights,
+             const arma::Col<ElemType>& biases,
+             int iterations,
+             const size_t threads = 1,
+             const size_t batchSize = 1);
 
   /**
-   * Classification function. After training, use the weightVectors matrix to
-   * classify test, and put the predicted classes in predictedLabels.
+   * Continue training on new data, starting from the current weights rather
+   * than from the WeightInitializationPolicy.  This can be called any number
+   * of times, for instance once for each batch of a stream of points.  Classes
+   * which have not been seen before (labels beyond the current number of
+   * classes) are added, with zero weights.
+   *
+   * @param data New training data.
+   * @param labels Labels of the new training data.
+   * @param epochs Maximum number of passes over the new data; training stops
+   *     earlier if every point is classified correctly.
+   */
+  void Train(const MatType& data,
+             const arma::Row<size_t>& labels,
+             const size_t epochs);
+
+  /**
+   * Classification function. After training, use the weights matrix and the
+   * biases to classify test, and put the predicted classes in predictedLabels.
+   * The test points are scored in blocks, with one matrix product per block,
+   * and the blocks are classified in parallel (with the number of threads given
+   * at construction) if OpenMP is available.
    *
    * @param test Testing data or data to classify.
    * @param predictedLabels Vector to store the predicted classes after
    *     classifying test.
    */
-  void Classify(const MatType& test, arma::Row<size_t>& predictedLabels);
+  void Classify(const MatType& test,
+                arma::Row<size_t>& predictedLabels) const;
 
   /**
+   * Classify a single point.  The score of each class is a dot product with
+   * that class's weights (contiguous for dense data); nothing is allocated,
+   * and this is safe to call from several threads at once, so it suits
+   * low-latency serving.
    *
+   * @param point Point to classify (with one value per attribute).
+   * @return The predicted class of the point (ties go to the lowest class).
+   */
+  size_t Predict(const ElemType* point) const;
+
+  /**
+   * Classify a single point.  This does not allocate memory.
    *
+   * @param point Point to classify.
+   * @return The predicted class of the point.
+   */
+  size_t Predict(const arma::Col<ElemType>& point) const;
+
+  /**
+   * Constructor for use as a weak learner in boosting.  Train a new perceptron
+   * on the given data, where each point carries the given instance weight,
+   * with the same number of iterations, threads and batch size as an existing
+   * perceptron.  The weights are applied by the LearnPolicy when a point is
+   * misclassified, so the data is not copied.
    *
+   * @param other Perceptron to take the number of iterations from.
+   * @param data Input, training data.
+   * @param instanceWeights Weight of each point of the training data.
+   * @param labels Labels of dataset.
    */
-  Perceptron(const Perceptron<>& other, MatType& data, const arma::Row<double>& D, const arma::Row<size_t>& labels);
+  Perceptron(const Perceptron& other,
+             const MatType& data,
+             const arma::rowvec& instanceWeights,
+             const arma::Row<size_t>& labels);
+
+  //! Get the weights of each class (one class per column, or per row for
+  //! sparse data; see ClassMajor).
+  const arma::Mat<ElemType>& Weights() const { return weights; }
+  //! Modify the weights of each class (one class per column, or per row for
+  //! sparse data; see ClassMajor).
+  arma::Mat<ElemType>& Weights() { return weights; }
+
+  //! Get the number of classes.
+  size_t NumClasses() const
+  { return ClassMajor ? weights.n_cols : weights.n_rows; }
+  //! Get the number of attributes of the data.
+  size_t Dimensionality() const
+  { return ClassMajor ? weights.n_rows : weights.n_cols; }
+
+  //! Get the bias of each class.
+  const arma::Col<ElemType>& Biases() const { return biases; }
+  //! Modify the bias of each class.
+  arma::Col<ElemType>& Biases() { return biases; }
 
 private:
   //! To store the number of iterations
   size_t iter;
 
-  //! Stores the class labels for the input data.
-  arma::Row<size_t> classLabels;
+  //! Stores the weight vectors for each of the input class labels (one class
+  //! per column for dense data, one class per row for sparse data).
+  arma::Mat<ElemType> weights;
+
+  //! Stores the bias of each class.
+  arma::Col<ElemType> biases;
+
+  //! Number of threads used for training and classification.
+  int numThreads;
 
-  //! Stores the weight vectors for each of the input class labels.
-  arma::mat weightVectors;
+  //! Number of points scored together during training.
+  size_t batchSize;
 
-  //! Stores the training data to be used later on in UpdateWeights.
-  arma::mat trainData;
+  /**
+   * Set the training options shared by every constructor.
+   *
+   * @param iterations Maximum number of iterations.
+   * @param threads Number of threads used for training and classification; 0
+   *     means the OpenMP default.  Without OpenMP, the shards of parameter
+   *     mixing are trained one after the other.
+   * @param batchSize Number of points scored together during training.
+   */
+  void SetOptions(const int iterations,
+                  const size_t threads,
+                  const size_t batchSize);
+
+  /**
+   * Train function.  Go over the training data until every point is classified
+   * correctly, or the maximum number of iterations is reached, updating the
+   * weights of each misclassified point with the LearnPolicy.
+   *
+   * With more than one thread, each iteration uses iterative parameter mixing:
+   * the points are split into one contiguous shard per thread, each shard runs
+   * an epoch from the current weights on its own copy of them, and the weights
+   * of the shards are then averaged.  Training has converged once no shard
+   * makes a mistake.  The result depends on the number of threads, but not on
+   * the scheduling of the threads.  A LearnPolicy which averages the weights
+   * (like AveragedWeightUpdate) averages them over each shard's epoch before
+   * they are mixed.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of dataset.
+   * @param instanceWeights Weight of each point of the training data (if
+   *     empty, every point has weight 1).
+   * @param maxIterations Maximum number of iterations.
+   */
+  void Train(const MatType& data,
+             const arma::Row<size_t>& labels,
+             const arma::rowvec& instanceWeights,
+             const size_t maxIterations);
+
+  /**
+   * Run one epoch of the perceptron learning rule over the points in
+   * [begin, end), updating the given weights and biases.
+   *
+   * With a batch size above 1, each batch of points is scored with the same
+   * weights (with a single matrix product, for dense data), and the updates of
+   * the misclassified points of the batch are then applied together; for dense
+   * data, this is one rank-k update, done by the BatchUpdateWeights() function
+   * of the LearnPolicy.
+   *
+   * @param data Input, training data.
+   * @param labels Labels of dataset.
+   * @param instanceWeights Weight of each point of the training data (if
+   *     empty, every point has weight 1).
+   * @param begin Index of the first point of the epoch.
+   * @param end One past the index of the last point of the epoch.
+   * @param epochWeights Weights to classify with and update.
+   * @param epochBiases Biases to classify with and update.
+   * @param LP LearnPolicy used to update the weights.
+   * @return true if every point was classified correctly.
+   */
+  bool TrainEpoch(const MatType& data,
+                  const arma::Row<size_t>& labels,
+                  const arma::rowvec& instanceWeights,
+                  const size_t begin,
+                  const size_t end,
+                  arma::Mat<ElemType>& epochWeights,
+                  arma::Col<ElemType>& epochBiases,
+                  LearnPolicy& LP) const;
+
+  /**
+   * Apply the updates of the misclassified points of a batch of a dense
+   * dataset, with a single rank-k update.
+   *
+   * @param data Dataset holding the points.
+   * @param labels Labels of dataset.
+   * @param instanceWeights Weight of each point of the training data (if
+   *     empty, every point has weight 1).
+   * @param mistakes Indices of the misclassified points.
+   * @param predictedClasses Class predicted for each misclassified point.
+   * @param epochWeights Weights to update.
+   * @param epochBiases Biases to update.
+   * @param LP LearnPolicy used to update the weights.
+   */
+  static void UpdateBatch(const arma::Mat<ElemType>& data,
+                          const arma::Row<size_t>& labels,
+                          const arma::rowvec& instanceWeights,
+                          const std::vector<arma::uword>& mistakes,
+                          const std::vector<size_t>& predictedClasses,
+                          arma::Mat<ElemType>& epochWeights,
+                          arma::Col<ElemType>& epochBiases,
+                          LearnPolicy& LP);
+
+  /**
+   * Apply the updates of the misclassified points of a batch of a sparse
+   * dataset, one point at a time (each update only touches the nonzeros of
+   * its point).
+   *
+   * @param data Dataset holding the points.
+   * @param labels Labels of dataset.
+   * @param instanceWeights Weight of each point of the training data (if
+   *     empty, every point has weight 1).
+   * @param mistakes Indices of the misclassified points.
+   * @param predictedClasses Class predicted for each misclassified point.
+   * @param epochWeights Weights to update.
+   * @param epochBiases Biases to update.
+   * @param LP LearnPolicy used to update the weights.
+   */
+  static void UpdateBatch(const arma::SpMat<ElemType>& data,
+                          const arma::Row<size_t>& labels,
+                          const arma::rowvec& instanceWeights,
+                          const std::vector<arma::uword>& mistakes,
+                          const std::vector<size_t>& predictedClasses,
+                          arma::Mat<ElemType>& epochWeights,
+                          arma::Col<ElemType>& epochBiases,
+                          LearnPolicy& LP);
+
+  /**
+   * Score the points in [begin, end) of a dense dataset: put the score of each
+   * class for each point, including its bias, in scores.
+   *
+   * @param scoreWeights Weights to score with (one class per column).
+   * @param scoreBiases Bias of each class.
+   * @param data Dataset holding the points.
+   * @param begin Index of the first point to score.
+   * @param end One past the index of the last point to score.
+   * @param scores Matrix to store the score of each class (row) for each point
+   *     (column) in.
+   */
+  static void Score(const arma::Mat<ElemType>& scoreWeights,
+                    const arma::Col<ElemType>& scoreBiases,
+                    const arma::Mat<ElemType>& data,
+                    const size_t begin,
+                    const size_t end,
+                    arma::Mat<ElemType>& scores);
 
   /**
-   * Train function.
+   * Score the points in [begin, end) of a sparse dataset, from their nonzeros
+   * only.
    *
+   * @param scoreWeights Weights to score with (one class per row).
+   * @param scoreBiases Bias of each class.
+   * @param data Dataset holding the points.
+   * @param begin Index of the first point to score.
+   * @param end One past the index of the last point to score.
+   * @param scores Matrix to store the score of each class (row) for each point
+   *     (column) in.
    */
-  void Train();
+  static void Score(const arma::Mat<ElemType>& scoreWeights,
+                    const arma::Col<ElemType>& scoreBiases,
+                    const arma::SpMat<ElemType>& data,
+                    const size_t begin,
+                    const size_t end,
+                    arma::Mat<ElemType>& scores);
 };
 
 } // namespace perceptron
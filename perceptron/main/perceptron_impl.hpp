@@ -9,19 +9,28 @@
 
 #include "perceptron.hpp"
 
+#include <algorithm>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace perceptron {
 
 /**
- * Constructor - constructs the perceptron. Or rather, builds the weightVectors
- * matrix, which is later used in Classification.
- * It adds a bias input vector of 1 to the input data to take care of the bias
- * weights.
+ * Constructor - constructs the perceptron. Or rather, builds the weights matrix
+ * and the biases vector, which are later used in Classification.  The bias is
+ * handled implicitly, so the data is used in place.
  *
  * @param data Input, training data.
  * @param labels Labels of dataset.
  * @param iterations Maximum number of iterations for the perceptron learning
  *      algorithm.
+ * @param threads Number of threads used for training and classification
+ *      (0 means the OpenMP default).
+ * @param batchSize Number of points scored together during training.
  */
 template<
     typename LearnPolicy,
@@ -31,28 +40,136 @@ template<
 Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
     const MatType& data,
     const arma::Row<size_t>& labels,
-    int iterations)
+    int iterations,
+    const size_t threads,
+    const size_t batchSize)
 {
+  SetOptions(iterations, threads, batchSize);
+
   WeightInitializationPolicy WIP;
-  WIP.Initialize(weightVectors, arma::max(labels) + 1, data.n_rows + 1);
+  WIP.Initialize(weights, biases, arma::max(labels) + 1, data.n_rows,
+      ClassMajor);
 
   // Start training.
-  classLabels = labels;
+  Train(data, labels, arma::rowvec(), iter);
+}
 
-  trainData = data;
-  // Insert a row of ones at the top of the training data set.
-  MatType zOnes(1, data.n_cols);
-  zOnes.fill(1);
-  trainData.insert_rows(0, zOnes);
+/**
+ * Construct an untrained perceptron, with weights given by the
+ * WeightInitializationPolicy.
+ *
+ * @param numClasses Number of classes.
+ * @param dimensionality Number of attributes of the data.
+ * @param iterations Maximum number of iterations used by the boosting
+ *      constructor.
+ * @param threads Number of threads used for training and classification
+ *      (0 means the OpenMP default).
+ * @param batchSize Number of points scored together during training.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
+    const size_t numClasses,
+    const size_t dimensionality,
+    int iterations,
+    const size_t threads,
+    const size_t batchSize)
+{
+  SetOptions(iterations, threads, batchSize);
 
-  iter = iterations;
-  Train();
+  WeightInitializationPolicy WIP;
+  WIP.Initialize(weights, biases, numClasses, dimensionality, ClassMajor);
 }
 
+/**
+ * Construct a perceptron from pre-trained weights and biases.
+ *
+ * @param weights Weights of each class (one class per column, or per row for
+ *      sparse data).
+ * @param biases Bias of each class.
+ * @param iterations Maximum number of iterations used by the boosting
+ *      constructor.
+ * @param threads Number of threads used for training and classification
+ *      (0 means the OpenMP default).
+ * @param batchSize Number of points scored together during training.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
+    const arma::Mat<ElemType>& weights,
+    const arma::Col<ElemType>& biases,
+    int iterations,
+    const size_t threads,
+    const size_t batchSize) :
+    weights(weights),
+    biases(biases)
+{
+  if (biases.n_elem != NumClasses())
+    Log::Fatal << "Perceptron: number of biases (" << biases.n_elem << ") does "
+        << "not match number of classes (" << NumClasses() << ")!"
+        << std::endl;
+
+  SetOptions(iterations, threads, batchSize);
+}
 
 /**
- * Classification function. After training, use the weightVectors matrix to
- * classify test, and put the predicted classes in predictedLabels.
+ * Continue training on new data, starting from the current weights.  Classes
+ * which have not been seen before are added, with zero weights.
+ *
+ * @param data New training data.
+ * @param labels Labels of the new training data.
+ * @param epochs Maximum number of passes over the new data.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const size_t epochs)
+{
+  if (data.n_rows != Dimensionality())
+    Log::Fatal << "Perceptron: data dimensionality (" << data.n_rows << ") "
+        << "does not match perceptron dimensionality (" << Dimensionality()
+        << ")!" << std::endl;
+  if (labels.n_elem != data.n_cols)
+    Log::Fatal << "Perceptron: number of labels (" << labels.n_elem << ") does "
+        << "not match number of points (" << data.n_cols << ")!" << std::endl;
+  if (data.n_cols == 0)
+    return;
+
+  // Add any new classes; resize() fills their weights with zeros.
+  const size_t numClasses = arma::max(labels) + 1;
+  if (numClasses > NumClasses())
+  {
+    if (ClassMajor)
+      weights.resize(weights.n_rows, numClasses);
+    else
+      weights.resize(numClasses, weights.n_cols);
+    biases.resize(numClasses);
+  }
+
+  Train(data, labels, arma::rowvec(), epochs);
+}
+
+
+/**
+ * Classification function. After training, use the weights matrix and the
+ * biases to classify test, and put the predicted classes in predictedLabels.
+ *
+ * The test points are scored in blocks: the scores of every class for a whole
+ * block come from a single matrix product (so BLAS can use GEMM), the biases
+ * are added, and the class with the largest score is found for each column.
+ * Sparse test points are scored from their nonzeros only.  Blocks are
+ * classified in parallel by numThreads threads, if OpenMP is available.
  *
  * @param test testing data or data to classify.
  * @param predictedLabels vector to store the predicted classes after
@@ -61,94 +178,530 @@ Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
 template <typename LearnPolicy, typename WeightInitializationPolicy, typename MatType>
 void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Classify(
     const MatType& test,
-    arma::Row<size_t>& predictedLabels)
+    arma::Row<size_t>& predictedLabels) const
 {
-  arma::mat tempLabelMat;
-  arma::uword maxIndexRow, maxIndexCol;
+  if (test.n_rows != Dimensionality())
+    Log::Fatal << "Perceptron: test data dimensionality (" << test.n_rows
+        << ") does not match perceptron dimensionality (" << Dimensionality()
+        << ")!" << std::endl;
 
-  for (int i = 0; i < test.n_cols; i++)
+  const size_t numClasses = NumClasses();
+  predictedLabels.set_size(test.n_cols);
+
+  const size_t blockSize = 512;
+  const int numBlocks = (test.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel num_threads(numThreads)
   {
-    tempLabelMat = weightVectors.submat(0, 1, weightVectors.n_rows - 1,
-                                        weightVectors.n_cols - 1) * 
-                                        test.col(i) + weightVectors.col(0);
-    tempLabelMat.max(maxIndexRow, maxIndexCol);
-    predictedLabels(0, i) = maxIndexRow;
+    // The scores of each block; reused by every block this thread handles.
+    arma::Mat<ElemType> scores;
+
+    #pragma omp for schedule(static)
+    for (int block = 0; block < numBlocks; block++)
+    {
+      const size_t begin = block * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) test.n_cols);
+
+      Score(weights, biases, test, begin, end, scores);
+
+      // Take the class with the largest score; ties go to the lowest class.
+      for (size_t i = 0; i < end - begin; ++i)
+      {
+        const ElemType* score = scores.colptr(i);
+        size_t best = 0;
+        for (size_t c = 1; c < numClasses; ++c)
+          if (score[c] > score[best])
+            best = c;
+
+        predictedLabels[begin + i] = best;
+      }
+    }
   }
-  // predictedLabels.print("These are the labels predicted by the perceptron");
 }
 
+/**
+ * Classify a single point, without allocating memory.
+ *
+ * @param point Point to classify (with one value per attribute).
+ * @return The predicted class of the point.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+size_t Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Predict(
+    const ElemType* point) const
+{
+  const size_t dimensionality = Dimensionality();
+
+  // The weights of a class are contiguous for dense data, and strided by the
+  // number of classes for sparse data.
+  const size_t stride = ClassMajor ? 1 : weights.n_rows;
+
+  // Take the class with the largest score; ties go to the lowest class.
+  size_t best = 0;
+  ElemType bestScore = 0;
+  for (size_t c = 0; c < NumClasses(); ++c)
+  {
+    const ElemType* weight = ClassMajor ? weights.colptr(c) :
+        weights.memptr() + c;
+    ElemType score = biases[c];
+    for (size_t i = 0; i < dimensionality; ++i)
+      score += weight[i * stride] * point[i];
+
+    if (c == 0 || score > bestScore)
+    {
+      best = c;
+      bestScore = score;
+    }
+  }
+
+  return best;
+}
+
+/**
+ * Classify a single point, without allocating memory.
+ *
+ * @param point Point to classify.
+ * @return The predicted class of the point.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+size_t Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Predict(
+    const arma::Col<ElemType>& point) const
+{
+  if (point.n_elem != Dimensionality())
+    Log::Fatal << "Perceptron: point dimensionality (" << point.n_elem << ") "
+        << "does not match perceptron dimensionality (" << Dimensionality()
+        << ")!" << std::endl;
+
+  return Predict(point.memptr());
+}
+
+/**
+ * Constructor for use as a weak learner in boosting.  Train a new perceptron on
+ * the given data, where each point carries the given instance weight.
+ *
+ * @param other Perceptron to take the number of iterations from.
+ * @param data Input, training data.
+ * @param instanceWeights Weight of each point of data.
+ * @param labels Labels of dataset.
+ */
 template <typename LearnPolicy, typename WeightInitializationPolicy, typename MatType>
 Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Perceptron(
-  const Perceptron<>& other, MatType& data, const arma::Row<double>& D, const arma::Row<size_t>& labels)
+    const Perceptron& other,
+    const MatType& data,
+    const arma::rowvec& instanceWeights,
+    const arma::Row<size_t>& labels)
 {
-  int i;
-  //transform data, as per rules for perceptron
-  D.print("The value of D in other constructor.");
-  trainData = arma::mat(data);
-  for (i = 0;i < data.n_cols; i++)
-    trainData.col(i) = D(i) * data.col(i);
-  // data.print("Values of the data after transformation.");
-  classLabels = labels;
-  // trainData = data;
   iter = other.iter;
-
-  // Insert a row of ones at the top of the training data set.
-  MatType zOnes(1, data.n_cols);
-  zOnes.fill(1);
-  trainData.insert_rows(0, zOnes);
+  numThreads = other.numThreads;
+  batchSize = other.batchSize;
 
   WeightInitializationPolicy WIP;
-  WIP.Initialize(weightVectors, arma::max(labels) + 1, data.n_rows + 1);
+  WIP.Initialize(weights, biases, arma::max(labels) + 1, data.n_rows,
+      ClassMajor);
 
-  Train();
+  Train(data, labels, instanceWeights, iter);
 }
 
 /**
- *  Training Function. 
+ * Set the training options shared by every constructor.
  *
+ * @param iterations Maximum number of iterations.
+ * @param threads Number of threads used for training and classification
+ *      (0 means the OpenMP default).
+ * @param batchSize Number of points scored together during training.
  */
 template<
     typename LearnPolicy,
     typename WeightInitializationPolicy,
     typename MatType
 >
-void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train()
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::SetOptions(
+    const int iterations,
+    const size_t threads,
+    const size_t batchSize)
+{
+  if (batchSize == 0)
+    Log::Fatal << "Perceptron: batch size must be positive!" << std::endl;
+
+  iter = iterations;
+  this->batchSize = batchSize;
+
+#ifdef _OPENMP
+  numThreads = (threads == 0) ? omp_get_max_threads() : (int) threads;
+#else
+  numThreads = (threads == 0) ? 1 : (int) threads;
+#endif
+}
+
+/**
+ *  Training Function.  The bias is the weight of an implicit constant input of
+ *  1, so each point is scored as weights * point + biases.
+ *
+ * @param data Input, training data.
+ * @param labels Labels of dataset.
+ * @param instanceWeights Weight of each point of data (if empty, every point
+ *      has weight 1).
+ * @param maxIterations Maximum number of iterations.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const size_t maxIterations)
 {
-  int j, i = 0;
+  if ((instanceWeights.n_elem > 0) && (instanceWeights.n_elem != data.n_cols))
+    Log::Fatal << "Perceptron: number of instance weights ("
+        << instanceWeights.n_elem << ") does not match number of points ("
+        << data.n_cols << ")!" << std::endl;
+
+  size_t i = 0;
   bool converged = false;
-  size_t tempLabel;
-  arma::uword maxIndexRow, maxIndexCol;
-  arma::mat tempLabelMat;
 
   LearnPolicy LP;
 
-  while ((i < iter) && (!converged))
+  // Parameter mixing needs at least one point per shard.
+  const size_t numShards = std::min((size_t) numThreads, (size_t) data.n_cols);
+  if (numShards <= 1)
+  {
+    LP.StartTraining(weights, biases);
+    while ((i < maxIterations) && (!converged))
+    {
+      // This outer loop is for each iteration, and we use the 'converged'
+      // variable for noting whether or not convergence has been reached.
+      i++;
+      converged = TrainEpoch(data, labels, instanceWeights, 0, data.n_cols,
+          weights, biases, LP);
+    }
+    LP.FinishTraining(weights, biases);
+
+    return;
+  }
+
+  // Each shard keeps its own LearnPolicy, and its own copy of the weights.
+  std::vector<LearnPolicy> shardPolicies(numShards, LP);
+  std::vector<arma::Mat<ElemType> > shardWeights(numShards);
+  std::vector<arma::Col<ElemType> > shardBiases(numShards);
+  std::vector<char> shardConverged(numShards);
+
+  while ((i < maxIterations) && (!converged))
   {
-    // This outer loop is for each iteration, and we use the 'converged'
-    // variable for noting whether or not convergence has been reached.
     i++;
+
+    #pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int shard = 0; shard < (int) numShards; shard++)
+    {
+      const size_t begin = shard * data.n_cols / numShards;
+      const size_t end = (shard + 1) * data.n_cols / numShards;
+
+      shardWeights[shard] = weights;
+      shardBiases[shard] = biases;
+      shardPolicies[shard].StartTraining(shardWeights[shard],
+          shardBiases[shard]);
+      shardConverged[shard] = TrainEpoch(data, labels, instanceWeights, begin,
+          end, shardWeights[shard], shardBiases[shard], shardPolicies[shard]);
+      shardPolicies[shard].FinishTraining(shardWeights[shard],
+          shardBiases[shard]);
+    }
+
     converged = true;
+    for (size_t shard = 0; shard < numShards; shard++)
+      converged = converged && shardConverged[shard];
 
-    // Now this inner loop is for going through the dataset in each iteration.
-    for (j = 0; j < trainData.n_cols; j++)
+    // If no shard made a mistake, the weights are unchanged.  Otherwise,
+    // average the weights of the shards, in order, so that the result does not
+    // depend on the scheduling.
+    if (!converged)
     {
-      // Multiply for each variable and check whether the current weight vector
-      // correctly classifies this.
-      tempLabelMat = weightVectors * trainData.col(j);
-
-      tempLabelMat.max(maxIndexRow, maxIndexCol);
-      
-      // Check whether prediction is correct.
-      if (maxIndexRow != classLabels(0, j))
+      weights = shardWeights[0];
+      biases = shardBiases[0];
+      for (size_t shard = 1; shard < numShards; shard++)
+      {
+        weights += shardWeights[shard];
+        biases += shardBiases[shard];
+      }
+      weights /= numShards;
+      biases /= numShards;
+    }
+  }
+}
+
+/**
+ * Run one epoch of the perceptron learning rule over the points in
+ * [begin, end).
+ *
+ * @param data Input, training data.
+ * @param labels Labels of dataset.
+ * @param instanceWeights Weight of each point of data (if empty, every point
+ *      has weight 1).
+ * @param begin Index of the first point of the epoch.
+ * @param end One past the index of the last point of the epoch.
+ * @param epochWeights Weights to classify with and update.
+ * @param epochBiases Biases to classify with and update.
+ * @param LP LearnPolicy used to update the weights.
+ * @return true if every point was classified correctly.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+bool Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::TrainEpoch(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const size_t begin,
+    const size_t end,
+    arma::Mat<ElemType>& epochWeights,
+    arma::Col<ElemType>& epochBiases,
+    LearnPolicy& LP) const
+{
+  const bool weighted = (instanceWeights.n_elem > 0);
+  bool converged = true;
+  size_t tempLabel;
+  arma::uword maxIndexRow, maxIndexCol;
+  arma::Mat<ElemType> tempLabelMat;
+
+  if (batchSize > 1)
+  {
+    std::vector<arma::uword> mistakes;
+    std::vector<size_t> predictedClasses;
+
+    for (size_t batchBegin = begin; batchBegin < end; batchBegin += batchSize)
+    {
+      const size_t batchEnd = std::min(batchBegin + batchSize, end);
+
+      // Score the whole batch with the same weights, and gather the points
+      // which are misclassified.
+      Score(epochWeights, epochBiases, data, batchBegin, batchEnd,
+          tempLabelMat);
+
+      mistakes.clear();
+      predictedClasses.clear();
+      for (size_t j = batchBegin; j < batchEnd; j++)
+      {
+        tempLabelMat.unsafe_col(j - batchBegin).max(maxIndexRow);
+        if (maxIndexRow != labels(0, j))
+        {
+          mistakes.push_back(j);
+          predictedClasses.push_back(maxIndexRow);
+        }
+      }
+
+      // The updates take effect after the last point of the batch.
+      for (size_t j = batchBegin + 1; j < batchEnd; j++)
+        LP.NextPoint();
+
+      if (!mistakes.empty())
       {
-        // Due to incorrect prediction, convergence set to false.
         converged = false;
-        tempLabel = classLabels(0, j);
-        // Send maxIndexRow for knowing which weight to update, send j to know
-        // the value of the vector to update it with.  Send tempLabel to know
-        // the correct class.
-        LP.UpdateWeights(trainData, weightVectors, j, tempLabel, maxIndexRow);
+        UpdateBatch(data, labels, instanceWeights, mistakes, predictedClasses,
+            epochWeights, epochBiases, LP);
       }
+
+      LP.NextPoint();
+    }
+
+    return converged;
+  }
+
+  // This loop is for going through the points of the epoch.
+  for (size_t j = begin; j < end; j++)
+  {
+    // Multiply for each variable and check whether the current weight vector
+    // correctly classifies this.
+    Score(epochWeights, epochBiases, data, j, j + 1, tempLabelMat);
+
+    tempLabelMat.max(maxIndexRow, maxIndexCol);
+
+    // Check whether prediction is correct.
+    if (maxIndexRow != labels(0, j))
+    {
+      // Due to incorrect prediction, convergence set to false.
+      converged = false;
+      tempLabel = labels(0, j);
+      // Send maxIndexRow for knowing which weight to update, send j to know
+      // the value of the vector to update it with.  Send tempLabel to know
+      // the correct class.
+      LP.UpdateWeights(data.col(j), epochWeights, epochBiases, maxIndexRow,
+          tempLabel, weighted ? instanceWeights(j) : 1.0);
+    }
+
+    LP.NextPoint();
+  }
+
+  return converged;
+}
+
+/**
+ * Apply the updates of the misclassified points of a batch of a dense dataset.
+ * The misclassified points are gathered, and the coefficient of each point for
+ * each class (minus its weight for the predicted class, plus its weight for
+ * the correct class) is put in a classes x k matrix, so that the LearnPolicy
+ * can apply every update with a single matrix product.
+ *
+ * @param data Dataset holding the points.
+ * @param labels Labels of dataset.
+ * @param instanceWeights Weight of each point of data (if empty, every point
+ *      has weight 1).
+ * @param mistakes Indices of the misclassified points.
+ * @param predictedClasses Class predicted for each misclassified point.
+ * @param epochWeights Weights to update.
+ * @param epochBiases Biases to update.
+ * @param LP LearnPolicy used to update the weights.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::UpdateBatch(
+    const arma::Mat<ElemType>& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const std::vector<arma::uword>& mistakes,
+    const std::vector<size_t>& predictedClasses,
+    arma::Mat<ElemType>& epochWeights,
+    arma::Col<ElemType>& epochBiases,
+    LearnPolicy& LP)
+{
+  arma::Mat<ElemType> coefficients(epochWeights.n_cols, mistakes.size());
+  coefficients.zeros();
+  for (size_t m = 0; m < mistakes.size(); m++)
+  {
+    const double weight = (instanceWeights.n_elem > 0) ?
+        instanceWeights(mistakes[m]) : 1.0;
+    coefficients(predictedClasses[m], m) -= weight;
+    coefficients(labels(0, mistakes[m]), m) += weight;
+  }
+
+  const arma::Mat<ElemType> points = data.cols(arma::uvec(mistakes));
+  LP.BatchUpdateWeights(points, epochWeights, epochBiases, coefficients);
+}
+
+/**
+ * Apply the updates of the misclassified points of a batch of a sparse
+ * dataset, one point at a time, so that each update only touches the nonzeros
+ * of its point.
+ *
+ * @param data Dataset holding the points.
+ * @param labels Labels of dataset.
+ * @param instanceWeights Weight of each point of data (if empty, every point
+ *      has weight 1).
+ * @param mistakes Indices of the misclassified points.
+ * @param predictedClasses Class predicted for each misclassified point.
+ * @param epochWeights Weights to update.
+ * @param epochBiases Biases to update.
+ * @param LP LearnPolicy used to update the weights.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::UpdateBatch(
+    const arma::SpMat<ElemType>& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const std::vector<arma::uword>& mistakes,
+    const std::vector<size_t>& predictedClasses,
+    arma::Mat<ElemType>& epochWeights,
+    arma::Col<ElemType>& epochBiases,
+    LearnPolicy& LP)
+{
+  for (size_t m = 0; m < mistakes.size(); m++)
+  {
+    const double weight = (instanceWeights.n_elem > 0) ?
+        instanceWeights(mistakes[m]) : 1.0;
+    LP.UpdateWeights(data.col(mistakes[m]), epochWeights, epochBiases,
+        predictedClasses[m], labels(0, mistakes[m]), weight);
+  }
+}
+
+/**
+ * Score the points in [begin, end) of a dense dataset, with a single matrix
+ * product.
+ *
+ * @param scoreWeights Weights to score with (one class per column).
+ * @param scoreBiases Bias of each class.
+ * @param data Dataset holding the points.
+ * @param begin Index of the first point to score.
+ * @param end One past the index of the last point to score.
+ * @param scores Matrix to store the score of each class (row) for each point
+ *      (column) in.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Score(
+    const arma::Mat<ElemType>& scoreWeights,
+    const arma::Col<ElemType>& scoreBiases,
+    const arma::Mat<ElemType>& data,
+    const size_t begin,
+    const size_t end,
+    arma::Mat<ElemType>& scores)
+{
+  // Use the points in place.
+  const arma::Mat<ElemType> block(const_cast<ElemType*>(data.colptr(begin)),
+      data.n_rows, end - begin, false, true);
+  scores = scoreWeights.t() * block;
+  scores.each_col() += scoreBiases;
+}
+
+/**
+ * Score the points in [begin, end) of a sparse dataset.  Only the nonzeros of
+ * each point are visited, and each one adds a (contiguous) column of the
+ * weights to the scores, so the cost is O(classes * nnz).
+ *
+ * @param scoreWeights Weights to score with (one class per row).
+ * @param scoreBiases Bias of each class.
+ * @param data Dataset holding the points.
+ * @param begin Index of the first point to score.
+ * @param end One past the index of the last point to score.
+ * @param scores Matrix to store the score of each class (row) for each point
+ *      (column) in.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Score(
+    const arma::Mat<ElemType>& scoreWeights,
+    const arma::Col<ElemType>& scoreBiases,
+    const arma::SpMat<ElemType>& data,
+    const size_t begin,
+    const size_t end,
+    arma::Mat<ElemType>& scores)
+{
+  const size_t numClasses = scoreWeights.n_rows;
+  scores.set_size(numClasses, end - begin);
+
+  for (size_t j = begin; j < end; ++j)
+  {
+    ElemType* score = scores.colptr(j - begin);
+    for (size_t c = 0; c < numClasses; ++c)
+      score[c] = scoreBiases[c];
+
+    typename arma::SpMat<ElemType>::const_iterator it = data.begin_col(j);
+    for ( ; it != data.end_col(j); ++it)
+    {
+      const ElemType* weight = scoreWeights.colptr(it.row());
+      for (size_t c = 0; c < numClasses; ++c)
+        score[c] += weight[c] * (*it);
     }
   }
 }
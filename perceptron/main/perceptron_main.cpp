@@ -7,6 +7,8 @@
 
 #include <mlpack/core.hpp>
 #include "perceptron.hpp"
+#include "quantized_perceptron.hpp"
+#include "feature_hasher.hpp"
 
 using namespace mlpack;
 using namespace mlpack::perceptron;
@@ -34,6 +36,13 @@ PROGRAM_INFO("Perceptron",
     "A test file is given through the --test_file (-T) parameter.  The "
     "predicted labels for the test set will be stored in the file specified by "
     "the --output_file (-o) parameter."
+    "\n"
+    "If --hash_bits (-H) is given, the training and test files are instead "
+    "read as text, with one point per line made of whitespace-separated "
+    "'feature:value' tokens (the value defaults to 1), where a feature can be "
+    "any string.  The features are hashed into 2^hash_bits dimensions, so the "
+    "size of the model does not depend on the number of distinct features.  "
+    "The labels must then be given with --labels_file (-l)."
     );
 
 // Necessary parameters
@@ -47,14 +56,48 @@ PARAM_STRING("output", "The file in which the predicted labels for the test set"
     " will be written.", "o", "output.csv");
 PARAM_INT("iterations","The maximum number of iterations the perceptron is "
   "to be run", "i", 1000)
+PARAM_INT("threads", "The number of threads used for training and "
+    "classification (0 uses all available cores).  With more than one thread, "
+    "the perceptron is trained by iterative parameter mixing.", "j", 1);
+PARAM_INT("batch_size", "The number of points scored together during training; "
+    "the updates of the misclassified points of a batch are applied at once.",
+    "b", 1);
+PARAM_FLAG("quantize", "If set, the test set is classified with a copy of the "
+    "trained perceptron whose weights are quantized to 8-bit integers, and the "
+    "agreement and accuracy difference between the quantized and the full "
+    "precision models are reported.", "q");
+PARAM_INT("hash_bits", "If nonzero, read the training and test sets as text "
+    "files of 'feature:value' tokens, and hash the features into 2^hash_bits "
+    "dimensions (at most 28 bits).", "H", 0);
 
 int main(int argc, char *argv[])
 {
   CLI::ParseCommandLine(argc, argv);
 
+  if (CLI::GetParam<int>("hash_bits") < 0 ||
+      CLI::GetParam<int>("hash_bits") > (int) FeatureHasher::MaxBits)
+    Log::Fatal << "--hash_bits must be between 0 and "
+        << (size_t) FeatureHasher::MaxBits << "!" << endl;
+  const size_t hashBits = CLI::GetParam<int>("hash_bits");
+  if (hashBits > 0 && !CLI::HasParam("labels_file"))
+    Log::Fatal << "--labels_file must be given with --hash_bits!" << endl;
+  if (hashBits > 0 && CLI::HasParam("quantize"))
+    Log::Fatal << "--quantize can't be used with --hash_bits!" << endl;
+
   const string trainingDataFilename = CLI::GetParam<string>("train_file");
-  mat trainingData;
-  data::Load(trainingDataFilename, trainingData, true);
+  const string testingDataFilename = CLI::GetParam<string>("test_file");
+  mat trainingData, testingData;
+  sp_mat hashedTrainingData, hashedTestingData;
+  if (hashBits > 0)
+  {
+    FeatureHasher hasher(hashBits);
+    hasher.Load(trainingDataFilename, hashedTrainingData);
+    hasher.Load(testingDataFilename, hashedTestingData);
+  }
+  else
+  {
+    data::Load(trainingDataFilename, trainingData, true);
+  }
 
   const string labelsFilename = CLI::GetParam<string>("labels_file");
   // Load labels.
@@ -89,24 +132,76 @@ int main(int argc, char *argv[])
   // normalize the labels
   data::NormalizeLabels(labelsIn.unsafe_col(0), labels, mappings);
 
-  const string testingDataFilename = CLI::GetParam<string>("test_file");
-  mat testingData;
-  data::Load(testingDataFilename, testingData, true);
+  if (hashBits == 0)
+    data::Load(testingDataFilename, testingData, true);
 
   if (testingData.n_rows != trainingData.n_rows)
     Log::Fatal << "Test data dimensionality (" << testingData.n_rows << ") "
         << "must be the same as training data (" << trainingData.n_rows - 1
         << ")!" << std::endl;
   int iterations = CLI::GetParam<int>("iterations");
-  
-  Timer::Start("Training");
-  Perceptron<> p(trainingData, labels, iterations);
-  Timer::Stop("Training");
-
-  Row<size_t> predictedLabels(testingData.n_cols);
-  Timer::Start("Testing");
-  p.Classify(testingData, predictedLabels);
-  Timer::Stop("Testing");
+
+  if (CLI::GetParam<int>("threads") < 0)
+    Log::Fatal << "--threads must be nonnegative!" << endl;
+  const size_t threads = CLI::GetParam<int>("threads");
+
+  if (CLI::GetParam<int>("batch_size") <= 0)
+    Log::Fatal << "--batch_size must be positive!" << endl;
+  const size_t batchSize = CLI::GetParam<int>("batch_size");
+
+  Row<size_t> predictedLabels;
+  if (hashBits > 0)
+  {
+    if (labels.n_elem != hashedTrainingData.n_cols)
+      Log::Fatal << "Number of labels (" << labels.n_elem << ") must be the "
+          << "same as the number of training points ("
+          << hashedTrainingData.n_cols << ")!" << endl;
+
+    Timer::Start("Training");
+    Perceptron<SimpleWeightUpdate, ZeroInitialization, sp_mat> p(
+        hashedTrainingData, labels.t(), iterations, threads, batchSize);
+    Timer::Stop("Training");
+
+    Timer::Start("Testing");
+    p.Classify(hashedTestingData, predictedLabels);
+    Timer::Stop("Testing");
+  }
+  else
+  {
+    Timer::Start("Training");
+    Perceptron<> p(trainingData, labels, iterations, threads, batchSize);
+    Timer::Stop("Training");
+
+    predictedLabels.set_size(testingData.n_cols);
+    if (CLI::HasParam("quantize"))
+    {
+      QuantizedPerceptron q(p, threads);
+
+      Timer::Start("Testing");
+      q.Classify(testingData, predictedLabels);
+      Timer::Stop("Testing");
+
+      // The accuracy can only be compared on the training set, which has
+      // labels.
+      const QuantizationReport trainReport = q.Compare(p, trainingData,
+          labels.t());
+      const QuantizationReport testReport = q.Compare(p, testingData);
+      Log::Info << "Quantized model agrees with the full precision model on "
+          << 100.0 * testReport.agreement << "% of the test set, and on "
+          << 100.0 * trainReport.agreement << "% of the training set." << endl;
+      Log::Info << "Training set accuracy: " << 100.0 *
+          trainReport.referenceAccuracy << "% (full precision), " << 100.0 *
+          trainReport.quantizedAccuracy << "% (quantized); difference "
+          << 100.0 * (trainReport.referenceAccuracy -
+          trainReport.quantizedAccuracy) << "%." << endl;
+    }
+    else
+    {
+      Timer::Start("Testing");
+      p.Classify(testingData, predictedLabels);
+      Timer::Stop("Testing");
+    }
+  }
 
   vec results;
   data::RevertLabels(predictedLabels, mappings, results);
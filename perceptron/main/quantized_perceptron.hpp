@@ -0,0 +1,282 @@
+/**
+ * @file quantized_perceptron.hpp
+ * @author Udit Saxena
+ *
+ * Definition of the QuantizedPerceptron class, an int8 copy of a trained
+ * perceptron for fast, bandwidth-light classification.
+ */
+#ifndef __MLPACK_METHODS_PERCEPTRON_QUANTIZED_PERCEPTRON_HPP
+#define __MLPACK_METHODS_PERCEPTRON_QUANTIZED_PERCEPTRON_HPP
+
+#include <mlpack/core.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * The result of comparing a QuantizedPerceptron with the perceptron it was
+ * built from, on the same points.
+ */
+struct QuantizationReport
+{
+  //! The fraction of points on which both models predict the same class.
+  double agreement;
+  //! The accuracy of the original perceptron (if labels were given).
+  double referenceAccuracy;
+  //! The accuracy of the quantized perceptron (if labels were given).
+  double quantizedAccuracy;
+};
+
+/**
+ * This class holds a trained perceptron with its weights quantized to 8-bit
+ * integers, which makes the weights 8 times smaller than doubles.  The weights
+ * of each class c are stored as round(w_c / s_c), with the per-class scale
+ * s_c = max |w_c| / 127.  Each point x is quantized in the same way when it is
+ * classified, with its own scale s_x, so the score of class c is computed with
+ * an integer dot product:
+ *
+ *   score_c = (sum_i q(w_c)_i * q(x)_i) * s_c * s_x + b_c.
+ *
+ * The biases are kept in double precision.  The predictions may differ from
+ * those of the original perceptron for points close to a decision boundary;
+ * Compare() measures how often that happens.
+ *
+ * @code
+ * Perceptron<> p(trainData, trainLabels, 1000);
+ * QuantizedPerceptron q(p);
+ * q.Classify(testData, predictedLabels);
+ * @endcode
+ */
+class QuantizedPerceptron
+{
+ public:
+  /**
+   * Quantize the weights of the given trained perceptron.
+   *
+   * @param perceptron Trained perceptron (any LearnPolicy, initialization or
+   *     element type).
+   * @param threads Number of threads used for classification; 0 means the
+   *     OpenMP default.
+   */
+  template<typename PerceptronType>
+  QuantizedPerceptron(const PerceptronType& perceptron,
+                      const size_t threads = 1) :
+      dimensionality(perceptron.Dimensionality()),
+      numClasses(perceptron.NumClasses()),
+      weights(dimensionality * numClasses),
+      scales(numClasses),
+      biases(arma::conv_to<arma::vec>::from(perceptron.Biases()))
+  {
+#ifdef _OPENMP
+    numThreads = (threads == 0) ? omp_get_max_threads() : (int) threads;
+#else
+    numThreads = (threads == 0) ? 1 : (int) threads;
+#endif
+
+    for (size_t c = 0; c < numClasses; ++c)
+    {
+      // A perceptron trained on sparse data keeps one class per row.
+      arma::vec classWeights;
+      if (PerceptronType::ClassMajor)
+        classWeights = arma::conv_to<arma::vec>::from(
+            perceptron.Weights().col(c));
+      else
+        classWeights = arma::conv_to<arma::vec>::from(
+            perceptron.Weights().row(c).t());
+      scales[c] = Quantize(classWeights.memptr(), dimensionality,
+          &weights[c * dimensionality]);
+    }
+  }
+
+  /**
+   * Classify the given points with the quantized weights.  The points are
+   * classified in parallel (with the number of threads given at construction),
+   * if OpenMP is available.
+   *
+   * @param test Points to classify (one per column).
+   * @param predictedLabels Vector to store the predicted classes in.
+   */
+  template<typename eT>
+  void Classify(const arma::Mat<eT>& test,
+                arma::Row<size_t>& predictedLabels) const
+  {
+    if (test.n_rows != dimensionality)
+      Log::Fatal << "QuantizedPerceptron: test data dimensionality ("
+          << test.n_rows << ") does not match model dimensionality ("
+          << dimensionality << ")!" << std::endl;
+
+    predictedLabels.set_size(test.n_cols);
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+      // The point being classified, and its quantized values; reused by
+      // every point this thread handles.
+      std::vector<double> point(dimensionality);
+      std::vector<int8_t> quantized(dimensionality);
+
+      #pragma omp for schedule(static)
+      for (int j = 0; j < (int) test.n_cols; ++j)
+      {
+        const eT* column = test.colptr(j);
+        for (size_t i = 0; i < dimensionality; ++i)
+          point[i] = column[i];
+
+        const double pointScale = (dimensionality == 0) ? 0.0 :
+            Quantize(&point[0], dimensionality, &quantized[0]);
+
+        // Take the class with the largest score; ties go to the lowest class.
+        size_t best = 0;
+        double bestScore = 0.0;
+        for (size_t c = 0; c < numClasses; ++c)
+        {
+          const double score = Dot(&weights[c * dimensionality],
+              &quantized[0]) * scales[c] * pointScale + biases[c];
+          if (c == 0 || score > bestScore)
+          {
+            best = c;
+            bestScore = score;
+          }
+        }
+
+        predictedLabels[j] = best;
+      }
+    }
+  }
+
+  /**
+   * Compare the predictions of the quantized model with those of the
+   * perceptron it was built from.  If labels are given, the accuracy of both
+   * models is measured too; otherwise, the accuracies are set to 0.
+   *
+   * @param perceptron Perceptron the model was built from.
+   * @param test Points to classify (one per column).
+   * @param labels True labels of the points (optional).
+   */
+  template<typename PerceptronType, typename eT>
+  QuantizationReport Compare(const PerceptronType& perceptron,
+                             const arma::Mat<eT>& test,
+                             const arma::Row<size_t>& labels =
+                                 arma::Row<size_t>()) const
+  {
+    arma::Row<size_t> referenceLabels, quantizedLabels;
+    perceptron.Classify(test, referenceLabels);
+    Classify(test, quantizedLabels);
+
+    QuantizationReport report;
+    report.agreement = report.referenceAccuracy = report.quantizedAccuracy =
+        0.0;
+    if (test.n_cols == 0)
+      return report;
+
+    report.agreement = (double) arma::accu(referenceLabels ==
+        quantizedLabels) / test.n_cols;
+    if (labels.n_elem == test.n_cols)
+    {
+      report.referenceAccuracy = (double) arma::accu(referenceLabels ==
+          labels) / test.n_cols;
+      report.quantizedAccuracy = (double) arma::accu(quantizedLabels ==
+          labels) / test.n_cols;
+    }
+
+    return report;
+  }
+
+  //! Get the number of attributes of the points.
+  size_t Dimensionality() const { return dimensionality; }
+  //! Get the number of classes.
+  size_t NumClasses() const { return numClasses; }
+
+  //! Get the quantized weights of the given class.
+  const int8_t* Weights(const size_t c) const
+  { return &weights[c * dimensionality]; }
+  //! Get the scale of the weights of each class.
+  const arma::vec& Scales() const { return scales; }
+  //! Get the bias of each class.
+  const arma::vec& Biases() const { return biases; }
+
+ private:
+  /**
+   * Quantize the given values to 8-bit integers with a common scale, so that
+   * the value of largest magnitude becomes +/-127.
+   *
+   * @param values Values to quantize.
+   * @param n Number of values.
+   * @param quantized Array to store the quantized values in.
+   * @return The scale of the quantized values (0 if every value is 0).
+   */
+  static double Quantize(const double* values,
+                         const size_t n,
+                         int8_t* quantized)
+  {
+    double maxValue = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      maxValue = std::max(maxValue, std::abs(values[i]));
+
+    if (maxValue == 0.0)
+    {
+      std::fill(quantized, quantized + n, 0);
+      return 0.0;
+    }
+
+    const double scale = maxValue / 127.0;
+    for (size_t i = 0; i < n; ++i)
+      quantized[i] = (int8_t) std::floor(values[i] / scale + 0.5);
+
+    return scale;
+  }
+
+  /**
+   * Compute the integer dot product of two quantized vectors of the model's
+   * dimensionality.  Products are summed in 32 bits over blocks short enough
+   * not to overflow, and the blocks in 64 bits.
+   */
+  int64_t Dot(const int8_t* a, const int8_t* b) const
+  {
+    // 127 * 127 * 65536 fits in a 32-bit integer.
+    const size_t blockSize = 65536;
+
+    int64_t total = 0;
+    for (size_t begin = 0; begin < dimensionality; begin += blockSize)
+    {
+      const size_t end = std::min(begin + blockSize, dimensionality);
+      int32_t sum = 0;
+      for (size_t i = begin; i < end; ++i)
+        sum += (int32_t) a[i] * (int32_t) b[i];
+      total += sum;
+    }
+
+    return total;
+  }
+
+  //! The number of attributes of the points.
+  size_t dimensionality;
+
+  //! The number of classes.
+  size_t numClasses;
+
+  //! The quantized weights, one class after another.
+  std::vector<int8_t> weights;
+
+  //! The scale of the weights of each class.
+  arma::vec scales;
+
+  //! The bias of each class.
+  arma::vec biases;
+
+  //! Number of threads used for classification.
+  int numThreads;
+};
+
+}; // namespace perceptron
+}; // namespace mlpack
+
+#endif
@@ -6,6 +6,9 @@
  */
 #include <mlpack/core.hpp>
 #include "main/perceptron.hpp"
+#include "main/kernel_perceptron.hpp"
+#include "main/quantized_perceptron.hpp"
+#include "main/feature_hasher.hpp"
 
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE A
@@ -151,4 +154,412 @@ BOOST_AUTO_TEST_CASE(NonLinearlySeparableDataset)
   BOOST_CHECK_EQUAL(predictedLabels(0, 3), 1);
 }
 
+/**
+ * This tests classification of a test set spanning many blocks, made of copies
+ * of a linearly separable training set; every copy must be classified like the
+ * training point it was copied from.
+ */
+BOOST_AUTO_TEST_CASE(BatchClassify)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> p(trainData, labels.row(0), 1000);
+
+  const mat testData = repmat(trainData, 1, 500);
+  Row<size_t> predictedLabels(testData.n_cols);
+  p.Classify(testData, predictedLabels);
+
+  BOOST_REQUIRE_EQUAL(predictedLabels.n_elem, 4500);
+  for (size_t i = 0; i < testData.n_cols; i++)
+    BOOST_REQUIRE_EQUAL(predictedLabels(0, i), labels(0, i % 9));
+}
+
+/**
+ * This tests training with instance weights: a point with weight 0 never
+ * updates the weights, so a contradicting point can be ignored, and the other
+ * points are learned as if it were not there.
+ */
+BOOST_AUTO_TEST_CASE(InstanceWeights)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 0 << 1 << endr
+            << 1 << 0 << 1 << 0 << 1 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 1 << 0 << 0;
+
+  rowvec instanceWeights;
+  instanceWeights << 1 << 1 << 1 << 1 << 0;
+
+  Perceptron<> other(trainData.cols(0, 3), labels.row(0).cols(0, 3), 1000);
+  Perceptron<> p(other, trainData, instanceWeights, labels.row(0));
+
+  Row<size_t> predictedLabels(trainData.n_cols);
+  p.Classify(trainData, predictedLabels);
+
+  BOOST_CHECK_EQUAL(predictedLabels(0, 0), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 1), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 2), 1);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 3), 0);
+}
+
+/**
+ * This tests the convergence of parallel training (iterative parameter mixing)
+ * on linearly separable data with 3 classes, where each of the 4 shards holds a
+ * copy of the Random3 dataset.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTraining)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> p(repmat(trainData, 1, 4), repmat(labels.row(0), 1, 4), 1000,
+      4);
+
+  Row<size_t> predictedLabels(trainData.n_cols);
+  p.Classify(trainData, predictedLabels);
+
+  for (size_t i = 0; i < trainData.n_cols; i++)
+    BOOST_CHECK_EQUAL(predictedLabels(0, i), labels(0, i));
+}
+
+/**
+ * This tests the averaged perceptron on the non-linearly separable dataset;
+ * with averaged weights, a few iterations are enough.
+ */
+BOOST_AUTO_TEST_CASE(AveragedNonLinearlySeparableDataset)
+{
+  mat trainData;
+  trainData << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8
+            << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8 << endr
+            << 1 << 1 << 1 << 1 << 1 << 1 << 1 << 1
+            << 2 << 2 << 2 << 2 << 2 << 2 << 2 << 2 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 0 << 1 << 1 << 1
+         << 0 << 0 << 0 << 1 << 0 << 1 << 1 << 1;
+
+  Perceptron<AveragedWeightUpdate> p(trainData, labels.row(0), 10);
+
+  mat testData;
+  testData << 3 << 4   << 5   << 6   << endr
+           << 3 << 2.3 << 1.7 << 1.5 << endr;
+  Row<size_t> predictedLabels(testData.n_cols);
+  p.Classify(testData, predictedLabels);
+
+  BOOST_CHECK_EQUAL(predictedLabels(0, 0), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 1), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 2), 1);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 3), 1);
+}
+
+/**
+ * This tests that a perceptron trained on sparse data classifies like one
+ * trained on the same data stored densely.
+ */
+BOOST_AUTO_TEST_CASE(SparseTraining)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr
+            << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> dense(trainData, labels.row(0), 1000);
+  Perceptron<SimpleWeightUpdate, ZeroInitialization, sp_mat> sparse(
+      sp_mat(trainData), labels.row(0), 1000);
+
+  mat testData;
+  testData << 0 << 1 << 1 << 4 << 5 << 2 << 0 << endr
+           << 1 << 0 << 1 << 1 << 1 << 5 << 0 << endr
+           << 0 << 0 << 0 << 0 << 0 << 0 << 0 << endr;
+  Row<size_t> denseLabels(testData.n_cols), sparseLabels(testData.n_cols);
+  dense.Classify(testData, denseLabels);
+  sparse.Classify(sp_mat(testData), sparseLabels);
+
+  for (size_t i = 0; i < testData.n_cols; i++)
+    BOOST_CHECK_EQUAL(sparseLabels(0, i), denseLabels(0, i));
+  BOOST_CHECK_EQUAL(sparseLabels(0, 0), 0);
+  BOOST_CHECK_EQUAL(sparseLabels(0, 1), 0);
+  BOOST_CHECK_EQUAL(sparseLabels(0, 2), 0);
+  BOOST_CHECK_EQUAL(sparseLabels(0, 3), 1);
+  BOOST_CHECK_EQUAL(sparseLabels(0, 4), 1);
+  BOOST_CHECK_EQUAL(sparseLabels(0, 5), 2);
+
+  // The sparse perceptron keeps one class per row, with the same weights.
+  BOOST_REQUIRE_EQUAL(sparse.NumClasses(), 3);
+  for (size_t c = 0; c < 3; c++)
+    for (size_t i = 0; i < 3; i++)
+      BOOST_REQUIRE_CLOSE(sparse.Weights()(c, i) + 1.0,
+          dense.Weights()(i, c) + 1.0, 1e-5);
+
+  for (size_t i = 0; i < testData.n_cols; i++)
+    BOOST_CHECK_EQUAL(sparse.Predict(testData.colptr(i)), denseLabels(0, i));
+}
+
+/**
+ * This tests the convergence of mini-batch training on linearly separable data
+ * with 3 classes.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchTraining)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> p(trainData, labels.row(0), 1000, 1, 4);
+
+  Row<size_t> predictedLabels(trainData.n_cols);
+  p.Classify(trainData, predictedLabels);
+
+  for (size_t i = 0; i < trainData.n_cols; i++)
+    BOOST_CHECK_EQUAL(predictedLabels(0, i), labels(0, i));
+}
+
+/**
+ * This tests incremental training: a perceptron trained on two classes keeps
+ * learning when a third class appears, and a perceptron built from its
+ * weights classifies in the same way.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalTraining)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> p(2, 2, 1000);
+  p.Train(trainData.cols(0, 5), labels.row(0).cols(0, 5), 1000);
+  BOOST_REQUIRE_EQUAL(p.Weights().n_cols, 2);
+
+  p.Train(trainData, labels.row(0), 1000);
+  BOOST_REQUIRE_EQUAL(p.Weights().n_cols, 3);
+  BOOST_REQUIRE_EQUAL(p.Biases().n_elem, 3);
+
+  Perceptron<> copy(p.Weights(), p.Biases(), 1000);
+
+  Row<size_t> predictedLabels(trainData.n_cols), copyLabels(trainData.n_cols);
+  p.Classify(trainData, predictedLabels);
+  copy.Classify(trainData, copyLabels);
+
+  for (size_t i = 0; i < trainData.n_cols; i++)
+  {
+    BOOST_CHECK_EQUAL(predictedLabels(0, i), labels(0, i));
+    BOOST_CHECK_EQUAL(copyLabels(0, i), labels(0, i));
+  }
+}
+
+/**
+ * This tests the convergence of a single-precision perceptron on linearly
+ * separable data with 3 classes.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecision)
+{
+  fmat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<SimpleWeightUpdate, ZeroInitialization, fmat> p(trainData,
+      labels.row(0), 1000);
+  BOOST_REQUIRE_EQUAL(p.Weights().n_cols, 3);
+
+  Row<size_t> predictedLabels(trainData.n_cols);
+  p.Classify(trainData, predictedLabels);
+
+  for (size_t i = 0; i < trainData.n_cols; i++)
+    BOOST_CHECK_EQUAL(predictedLabels(0, i), labels(0, i));
+}
+
+/**
+ * This tests that a quantized copy of a trained perceptron classifies linearly
+ * separable data like the original.
+ */
+BOOST_AUTO_TEST_CASE(QuantizedClassify)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  Perceptron<> p(trainData, labels.row(0), 1000);
+  QuantizedPerceptron q(p);
+  BOOST_REQUIRE_EQUAL(q.NumClasses(), 3);
+  BOOST_REQUIRE_EQUAL(q.Dimensionality(), 2);
+
+  Row<size_t> predictedLabels(trainData.n_cols);
+  q.Classify(trainData, predictedLabels);
+
+  for (size_t i = 0; i < trainData.n_cols; i++)
+    BOOST_CHECK_EQUAL(predictedLabels(0, i), labels(0, i));
+
+  const QuantizationReport report = q.Compare(p, trainData, labels.row(0));
+  BOOST_REQUIRE_CLOSE(report.agreement, 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(report.quantizedAccuracy, report.referenceAccuracy,
+      1e-5);
+}
+
+/**
+ * This tests that classifying points one at a time with Predict() gives the
+ * same labels as classifying them together with Classify().
+ */
+BOOST_AUTO_TEST_CASE(PredictMatchesClassify)
+{
+  mat trainData;
+  trainData << 0 << 1 << 1 << 4 << 5 << 4 << 1 << 2 << 1 << endr
+            << 1 << 0 << 1 << 1 << 1 << 2 << 4 << 5 << 4 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1 << 2 << 2 << 2;
+
+  const Perceptron<> p(trainData, labels.row(0), 1000);
+
+  const mat testData = 5 * randu<mat>(2, 100);
+  Row<size_t> predictedLabels(testData.n_cols);
+  p.Classify(testData, predictedLabels);
+
+  for (size_t i = 0; i < testData.n_cols; i++)
+  {
+    BOOST_CHECK_EQUAL(p.Predict(testData.colptr(i)), predictedLabels(0, i));
+    BOOST_CHECK_EQUAL(p.Predict(vec(testData.col(i))), predictedLabels(0, i));
+  }
+}
+
+/**
+ * This tests that a kernel perceptron with a Gaussian kernel fits the
+ * non-linearly separable dataset, which a linear perceptron can't.
+ */
+BOOST_AUTO_TEST_CASE(KernelNonLinearlySeparableDataset)
+{
+  mat trainData;
+  trainData << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8
+            << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8 << endr
+            << 1 << 1 << 1 << 1 << 1 << 1 << 1 << 1
+            << 2 << 2 << 2 << 2 << 2 << 2 << 2 << 2 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 0 << 1 << 1 << 1
+         << 0 << 0 << 0 << 1 << 0 << 1 << 1 << 1;
+
+  KernelPerceptron<> p(trainData, labels.row(0), 1000, 16, 16,
+      kernel::GaussianKernel(1.0));
+  BOOST_REQUIRE_LE(p.NumSupportVectors(), 16);
+
+  Row<size_t> predictedLabels(trainData.n_cols);
+  p.Classify(trainData, predictedLabels);
+
+  for (size_t i = 0; i < trainData.n_cols; i++)
+    BOOST_CHECK_EQUAL(predictedLabels(0, i), labels(0, i));
+}
+
+/**
+ * This tests that the number of support vectors never exceeds the budget, and
+ * that the size of the kernel cache does not change the result.
+ */
+BOOST_AUTO_TEST_CASE(KernelBudget)
+{
+  mat trainData;
+  trainData << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8
+            << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8 << endr
+            << 1 << 1 << 1 << 1 << 1 << 1 << 1 << 1
+            << 2 << 2 << 2 << 2 << 2 << 2 << 2 << 2 << endr;
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 0 << 1 << 1 << 1
+         << 0 << 0 << 0 << 1 << 0 << 1 << 1 << 1;
+
+  KernelPerceptron<> small(trainData, labels.row(0), 100, 4, 1,
+      kernel::GaussianKernel(1.0));
+  KernelPerceptron<> large(trainData, labels.row(0), 100, 4, 16,
+      kernel::GaussianKernel(1.0));
+  BOOST_REQUIRE_EQUAL(small.NumSupportVectors(), 4);
+  BOOST_REQUIRE_EQUAL(large.NumSupportVectors(), 4);
+
+  const mat testData = 10 * randu<mat>(2, 100);
+  Row<size_t> smallLabels, largeLabels;
+  small.Classify(testData, smallLabels);
+  large.Classify(testData, largeLabels);
+
+  for (size_t i = 0; i < testData.n_cols; i++)
+    BOOST_CHECK_EQUAL(smallLabels(0, i), largeLabels(0, i));
+}
+
+/**
+ * This tests that points made of named features are hashed consistently
+ * (with the values of colliding features summed), and that a sparse perceptron
+ * learns from the hashed points.
+ */
+BOOST_AUTO_TEST_CASE(FeatureHashing)
+{
+  FeatureHasher hasher(10);
+  BOOST_REQUIRE_EQUAL(hasher.Dimensionality(), 1024);
+
+  std::vector<std::string> train;
+  train.push_back("apple banana");
+  train.push_back("banana cherry:2");
+  train.push_back("apple cherry");
+  train.push_back("car truck");
+  train.push_back("truck bus:2");
+  train.push_back("car bus");
+
+  Mat<size_t> labels;
+  labels << 0 << 0 << 0 << 1 << 1 << 1;
+
+  sp_mat trainData;
+  hasher.Transform(train, trainData);
+  BOOST_REQUIRE_EQUAL(trainData.n_rows, 1024);
+  BOOST_REQUIRE_EQUAL(trainData.n_cols, 6);
+
+  // The same feature always lands on the same row, with the same sign.
+  std::vector<std::string> repeated;
+  repeated.push_back("apple apple:2");
+  repeated.push_back("apple apple:-1");
+  sp_mat repeatedData;
+  hasher.Transform(repeated, repeatedData);
+
+  double sign;
+  const size_t row = hasher.Index("apple", sign);
+  BOOST_REQUIRE_EQUAL(repeatedData.n_nonzero, 1);
+  BOOST_REQUIRE_CLOSE((double) repeatedData(row, 0), 3 * sign, 1e-5);
+
+  Perceptron<SimpleWeightUpdate, ZeroInitialization, sp_mat> p(trainData,
+      labels.row(0), 1000);
+
+  std::vector<std::string> test;
+  test.push_back("apple");
+  test.push_back("cherry banana");
+  test.push_back("car");
+  test.push_back("truck bus");
+  sp_mat testData;
+  hasher.Transform(test, testData);
+
+  Row<size_t> predictedLabels(testData.n_cols);
+  p.Classify(testData, predictedLabels);
+
+  BOOST_CHECK_EQUAL(predictedLabels(0, 0), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 1), 0);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 2), 1);
+  BOOST_CHECK_EQUAL(predictedLabels(0, 3), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END();